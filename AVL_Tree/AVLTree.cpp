@@ -31,11 +31,17 @@ bool Tree<T, V>::nodeExist(const T key) const {
 
 template<class T, class V>
 bool Tree<T, V>::nodeExist(Node *root, const T key) const {
-    if (root == nullptr)
-        return false;
-    if (root->key == key)
-        return true;
-    return nodeExist(root->left_son, key) || nodeExist(root->right_son, key);
+    int visited = 0;
+    while (root != nullptr && root->key != key) {
+        visited++;
+        if (key < root->key)
+            root = root->left_son;
+        else
+            root = root->right_son;
+    }
+    AVL_STATS_ADD(STATS_LOOKUPS, 1);
+    AVL_STATS_ADD(STATS_LOOKUP_NODES_VISITED, visited + (root != nullptr));
+    return root != nullptr;
 }
 
 template<class T, class V>
@@ -62,7 +68,7 @@ void Tree<T, V>::insert(const T key, const V data) {
 
 template<class T, class V>
 typename Tree<T, V>::Node *Tree<T, V>::insertNodeRecursion(Node *current, Node *const new_node) {
-    Node *new_sub_root_after_rotate;
+    Node *new_sub_root_after_rotate = nullptr;
     // stop conditions
     if (current == nullptr)
         return nullptr;
@@ -106,20 +112,24 @@ template<class T, class V>
 typename Tree<T, V>::Node *Tree<T, V>::rotate(Node *sub_root) {
     Node *new_sub_root;
     if (sub_root->balance == 2 && sub_root->left_son->balance >= 0) { // LL ROTATE
+        AVL_STATS_ADD(STATS_LL_ROTATIONS, 1);
         new_sub_root = LLrotate(sub_root);
         return new_sub_root;
     }
     else if (sub_root->balance == -2 && sub_root->right_son->balance <= 0) { // RR ROTATE
+        AVL_STATS_ADD(STATS_RR_ROTATIONS, 1);
         new_sub_root = RRrotate(sub_root);
         return new_sub_root;
     }
     else if (sub_root->balance == 2 && sub_root->left_son->balance == -1) { // LR ROTATE
+        AVL_STATS_ADD(STATS_LR_ROTATIONS, 1);
         Node *ll_sub_root = RRrotate(sub_root->left_son);
         sub_root->left_son = ll_sub_root;
         new_sub_root = LLrotate(sub_root);
         return new_sub_root;
     }
     else if (sub_root->balance == -2 && sub_root->right_son->balance == 1) { //RL ROTATE
+        AVL_STATS_ADD(STATS_RL_ROTATIONS, 1);
         Node *rr_sub_root = LLrotate(sub_root->right_son);
         sub_root->right_son = rr_sub_root;
         new_sub_root = RRrotate(sub_root);
@@ -346,6 +356,31 @@ void Tree<T, V>::getNodesRecursion(std::vector<Node *> &nodes_vector, Node *root
     getNodesRecursion(nodes_vector, root->right_son);
 }
 
+// checks keys order, heights, balances and the AVL condition of the whole tree
+template<class T, class V>
+bool Tree<T, V>::checkInvariants() const {
+    int nodes = 0;
+    return checkInvariantsRecursion(root, nullptr, nullptr, nodes) != -2 && nodes == nodes_counter;
+}
+
+// returns the height of the sub tree, or -2 if any invariant is broken
+template<class T, class V>
+int Tree<T, V>::checkInvariantsRecursion(const Node *root, const T *low, const T *high, int &nodes) const {
+    if (root == nullptr)
+        return -1;
+    nodes++;
+    if ((low != nullptr && !(*low < root->key)) || (high != nullptr && !(root->key < *high)))
+        return -2;
+    int left_height = checkInvariantsRecursion(root->left_son, low, &root->key, nodes);
+    int right_height = checkInvariantsRecursion(root->right_son, &root->key, high, nodes);
+    if (left_height == -2 || right_height == -2)
+        return -2;
+    int height = (left_height > right_height ? left_height : right_height) + 1;
+    if (root->height != height || root->balance != left_height - right_height || abs(root->balance) > 1)
+        return -2;
+    return height;
+}
+
 #endif /* DEBUG_ON */
 
 
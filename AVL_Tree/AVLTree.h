@@ -1,5 +1,6 @@
 // -------------------- LIBRARIES --------------------
 #include <iostream>
+#include <vector>
 #include <exception>
 #include <cassert>
 
@@ -7,6 +8,8 @@
 #ifndef AVL_TEST_H
 #define AVL_TEST_H
 
+#include "treeStats.h"
+
 // ----------------- ROTATE EXCEPTION -----------------
 class rotateError : public std::exception {
 public:
@@ -30,7 +33,15 @@ private:
         Node *right_son;
 
         explicit Node(const T key, const V data) : key(key), data(data), height(0), balance(0), left_son(nullptr),
-                                                   right_son(nullptr) {}
+                                                   right_son(nullptr) {
+            AVL_STATS_ADD(STATS_ALLOCATIONS, 1);
+        }
+
+#ifdef AVL_STATS_ON
+        ~Node() {
+            AVL_STATS_ADD(STATS_DEALLOCATIONS, 1);
+        }
+#endif /* AVL_STATS_ON */
 
         void updateBalance() {
             int left_son_height = getSonHeight(left_son);
@@ -102,6 +113,10 @@ public:
 
     void getNodesRecursion(std::vector<Node *> &nodes_vector, Node *root);
 
+    bool checkInvariants() const;
+
+    int checkInvariantsRecursion(const Node *root, const T *low, const T *high, int &nodes) const;
+
 #endif /* DEBUG_ON */
 };
 
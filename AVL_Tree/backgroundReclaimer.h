@@ -0,0 +1,100 @@
+#ifndef AVL_BACKGROUND_RECLAIMER_H
+#define AVL_BACKGROUND_RECLAIMER_H
+
+// -------------------- LIBRARIES --------------------
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <functional>
+#include <utility>
+
+// --------------------- READ ME ---------------------
+// One process wide thread that frees what the trees and tables in background destruction mode hand to it
+// (see Tree::setBackgroundDestruction and HashTable::setBackgroundDestruction), so their owner thread pays O(1)
+// for a destruction or a replacement instead of freeing every node itself.
+// The thread starts with the first use and is never joined (the reclaimer lives until the process exits, so
+// objects destroyed at exit can still hand work to it), work still queued at exit is dropped with the process.
+// Functions: instance, retire, drain (wait until every retired task ran), getRetiredCounter.
+// BackgroundStorage - the node storage of a Tree with setBackgroundDestruction (see NODE STORAGE in
+// rankedAVLTree.h), its State is the destruction mode and retire hands the old nodes to the reclaimer.
+
+class BackgroundReclaimer {
+private:
+    std::mutex lock;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    std::deque<std::function<void()>> tasks;
+    int running_tasks;
+    long long retired_counter;
+
+    BackgroundReclaimer() : running_tasks(0), retired_counter(0) {
+        std::thread(&BackgroundReclaimer::run, this).detach();
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            work_ready.wait(guard, [this]() { return !tasks.empty(); });
+            std::function<void()> task = std::move(tasks.front());
+            tasks.pop_front();
+            running_tasks++;
+            guard.unlock();
+            task();
+            task = nullptr;
+            guard.lock();
+            running_tasks--;
+            if (tasks.empty() && running_tasks == 0)
+                work_done.notify_all();
+        }
+    }
+
+public:
+    BackgroundReclaimer(const BackgroundReclaimer &other) = delete;
+
+    BackgroundReclaimer &operator=(const BackgroundReclaimer &other) = delete;
+
+    static BackgroundReclaimer &instance() {
+        static BackgroundReclaimer *reclaimer = new BackgroundReclaimer(); // never destroyed, see READ ME
+        return *reclaimer;
+    }
+
+    // runs "task" on the reclaimer thread, in retire order
+    void retire(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            tasks.push_back(std::move(task));
+            retired_counter++;
+        }
+        work_ready.notify_one();
+    }
+
+    void drain() {
+        std::unique_lock<std::mutex> guard(lock);
+        work_done.wait(guard, [this]() { return tasks.empty() && running_tasks == 0; });
+    }
+
+    long long getRetiredCounter() {
+        std::lock_guard<std::mutex> guard(lock);
+        return retired_counter;
+    }
+};
+
+// ----------------- BACKGROUND STORAGE -----------------
+struct BackgroundStorage {
+    static constexpr bool arena = false;
+    static constexpr bool background = true;
+
+    template<class keyType>
+    struct State {
+        bool background_destruction;
+
+        State() : background_destruction(false) {}
+    };
+
+    static void retire(std::function<void()> task) {
+        BackgroundReclaimer::instance().retire(std::move(task));
+    }
+};
+
+#endif /* AVL_BACKGROUND_RECLAIMER_H */
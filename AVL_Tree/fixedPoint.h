@@ -0,0 +1,80 @@
+#ifndef AVL_FIXED_POINT_H
+#define AVL_FIXED_POINT_H
+
+// -------------------- LIBRARIES --------------------
+#include <iostream>
+#include <cstdint>
+
+// --------------------- READ ME ---------------------
+// Fixed point rank type for the ranked trees: a "storageType" integer counting units of 2^-fraction_bits.
+// Addition and subtraction are exact integer operations, so lazy collectors never drift like double does.
+// Integers convert implicitly (upgradeRank(key_1, key_2, 1) works as with double), doubles explicitly.
+// Functions: fromRaw, getRaw, toDouble and the +, -, +=, -=, ==, !=, <, <<  operators.
+
+// ----------------- FIXED POINT CLASS -----------------
+template<int fraction_bits, class storageType = int64_t>
+class FixedPoint {
+private:
+    storageType value;
+
+public:
+    FixedPoint() : value(0) {}
+
+    FixedPoint(int integer) : value((storageType) ((storageType) integer * ((storageType) 1 << fraction_bits))) {}
+
+    explicit FixedPoint(double real) : value((storageType) (real * (double) ((storageType) 1 << fraction_bits))) {}
+
+    static FixedPoint fromRaw(storageType raw) {
+        FixedPoint fixed;
+        fixed.value = raw;
+        return fixed;
+    }
+
+    storageType getRaw() const {
+        return value;
+    }
+
+    double toDouble() const {
+        return (double) value / (double) ((storageType) 1 << fraction_bits);
+    }
+
+    FixedPoint &operator+=(const FixedPoint &other) {
+        value += other.value;
+        return *this;
+    }
+
+    FixedPoint &operator-=(const FixedPoint &other) {
+        value -= other.value;
+        return *this;
+    }
+
+    FixedPoint operator-() const {
+        return fromRaw(-value);
+    }
+
+    friend FixedPoint operator+(FixedPoint first, const FixedPoint &second) {
+        return first += second;
+    }
+
+    friend FixedPoint operator-(FixedPoint first, const FixedPoint &second) {
+        return first -= second;
+    }
+
+    friend bool operator==(const FixedPoint &first, const FixedPoint &second) {
+        return first.value == second.value;
+    }
+
+    friend bool operator!=(const FixedPoint &first, const FixedPoint &second) {
+        return first.value != second.value;
+    }
+
+    friend bool operator<(const FixedPoint &first, const FixedPoint &second) {
+        return first.value < second.value;
+    }
+
+    friend std::ostream &operator<<(std::ostream &stream, const FixedPoint &fixed) {
+        return stream << fixed.toDouble();
+    }
+};
+
+#endif /* AVL_FIXED_POINT_H */
@@ -0,0 +1,393 @@
+#ifndef AVL_FIXED_RANKED_TREE_H
+#define AVL_FIXED_RANKED_TREE_H
+
+// -------------------- LIBRARIES --------------------
+#include <array>
+#include <exception>
+
+// -------------------- DEFINES --------------------
+#define FIXED_TREE_NULL (-1) // index of a missing son
+
+// ---------------- CAPACITY EXCEPTION ----------------
+class capacityError : public std::exception {
+public:
+    const char *what() const noexcept override {
+        return "Capacity Error";
+    }
+};
+
+// --------------------- READ ME ---------------------
+// Fixed capacity AVL ranked tree, same rank semantics and API as Tree in rankedAVLTree.h.
+// Every node lives in an inline std::array, sons are array indexes, removed nodes go to a free list:
+// insert / remove never allocate and construction allocates nothing. Inserting into a full tree throws capacityError.
+// Every function is constexpr, so a small tree can be built at compile time:
+//     constexpr auto table = [] { FixedTree<int, int, 8> tree; tree.insert(1, 10); return tree; }();
+// No split / join / set operations - nodes cannot move between two fixed arrays.
+// The sons of a Node are array indexes, not pointers as in Tree: getNode gives the node of an index.
+// Functions: init, insert, remove, find, getRoot, getNode, upgradeRank, getNodeRank, getNodeCounter, getCapacity,
+// exportInorder / buildFromSorted.
+
+// --------------- FIXED AVL TREE CLASS ---------------
+template<class keyType, class dataType, int capacity, class rankType = double>
+class FixedTree {
+public:
+
+    class Node {
+    public:
+        keyType key;
+        dataType data;
+        rankType collector; // collector to calculate node rank from root to node
+        rankType rank;
+        int height;
+        int left_son; // index, FIXED_TREE_NULL if there is none (next free node while on the free list)
+        int right_son;
+
+        constexpr Node() : key(), data(), collector(), rank(), height(0), left_son(FIXED_TREE_NULL),
+                           right_son(FIXED_TREE_NULL) {}
+    };
+
+private:
+    std::array<Node, capacity> nodes;
+    int root;
+    int used_nodes; // nodes below this index were handed out at least once
+    int free_nodes; // head of the free list
+    int avl_nodes_counter;
+
+    // ----------- TREE PRIVATE FUNCTIONS -----------
+    constexpr int allocateNode(const keyType key, const dataType data, rankType collector) {
+        int index = free_nodes;
+        if (index != FIXED_TREE_NULL)
+            free_nodes = nodes[index].left_son;
+        else if (used_nodes < capacity)
+            index = used_nodes++;
+        else
+            throw capacityError();
+        Node &node = nodes[index];
+        node.key = key;
+        node.data = data;
+        node.collector = collector;
+        node.rank = rankType();
+        node.height = 0;
+        node.left_son = FIXED_TREE_NULL;
+        node.right_son = FIXED_TREE_NULL;
+        avl_nodes_counter++;
+        return index;
+    }
+
+    constexpr void freeNode(int index) {
+        nodes[index].left_son = free_nodes;
+        free_nodes = index;
+        avl_nodes_counter--;
+    }
+
+    constexpr int getHeight(int index) const {
+        return index == FIXED_TREE_NULL ? -1 : nodes[index].height;
+    }
+
+    constexpr void updateHeight(int index) {
+        Node &node = nodes[index];
+        int left_height = getHeight(node.left_son);
+        int right_height = getHeight(node.right_son);
+        node.height = (left_height > right_height ? left_height : right_height) + 1;
+    }
+
+    // moves the pending collector into the node rank and down to its sons
+    constexpr void pushCollector(int index) {
+        Node &node = nodes[index];
+        if (node.collector == rankType())
+            return;
+        if (node.left_son != FIXED_TREE_NULL)
+            nodes[node.left_son].collector += node.collector;
+        if (node.right_son != FIXED_TREE_NULL)
+            nodes[node.right_son].collector += node.collector;
+        node.rank += node.collector;
+        node.collector = rankType();
+    }
+
+    // both rotated nodes push their collectors first, so moving a sub tree keeps its ranks
+    constexpr int LLrotate(int father) {
+        pushCollector(father);
+        int son = nodes[father].left_son;
+        pushCollector(son);
+        nodes[father].left_son = nodes[son].right_son;
+        nodes[son].right_son = father;
+        updateHeight(father);
+        updateHeight(son);
+        return son;
+    }
+
+    constexpr int RRrotate(int father) {
+        pushCollector(father);
+        int son = nodes[father].right_son;
+        pushCollector(son);
+        nodes[father].right_son = nodes[son].left_son;
+        nodes[son].left_son = father;
+        updateHeight(father);
+        updateHeight(son);
+        return son;
+    }
+
+    constexpr int rebalance(int index) {
+        updateHeight(index);
+        Node &node = nodes[index];
+        int balance = getHeight(node.left_son) - getHeight(node.right_son);
+        if (balance > 1) {
+            const Node &son = nodes[node.left_son];
+            if (getHeight(son.left_son) < getHeight(son.right_son)) // LR ROTATE
+                node.left_son = RRrotate(node.left_son);
+            return LLrotate(index);
+        }
+        if (balance < -1) {
+            const Node &son = nodes[node.right_son];
+            if (getHeight(son.right_son) < getHeight(son.left_son)) // RL ROTATE
+                node.right_son = LLrotate(node.right_son);
+            return RRrotate(index);
+        }
+        return index;
+    }
+
+    // "inserted" gets the index of the new node
+    constexpr int insertNode(int index, const keyType key, const dataType data, rankType current_collector,
+                             int &inserted) {
+        if (index == FIXED_TREE_NULL)
+            return inserted = allocateNode(key, data, rankType() - current_collector); // starts with rank 0
+        current_collector += nodes[index].collector;
+        if (key < nodes[index].key) {
+            int left = insertNode(nodes[index].left_son, key, data, current_collector, inserted);
+            nodes[index].left_son = left;
+        }
+        else {
+            int right = insertNode(nodes[index].right_son, key, data, current_collector, inserted);
+            nodes[index].right_son = right;
+        }
+        return rebalance(index);
+    }
+
+    // detaches the minimum into "min_index", with every collector above it pushed
+    constexpr int removeMinNode(int index, int &min_index) {
+        pushCollector(index);
+        if (nodes[index].left_son == FIXED_TREE_NULL) {
+            min_index = index;
+            return nodes[index].right_son;
+        }
+        int left = removeMinNode(nodes[index].left_son, min_index);
+        nodes[index].left_son = left;
+        return rebalance(index);
+    }
+
+    // every node on the path pushes its collector, so nodes can be relinked without losing ranks
+    constexpr int removeNode(int index, const keyType key) {
+        pushCollector(index);
+        Node &node = nodes[index];
+        if (key < node.key) {
+            int left = removeNode(node.left_son, key);
+            nodes[index].left_son = left;
+            return rebalance(index);
+        }
+        if (node.key < key) {
+            int right = removeNode(node.right_son, key);
+            nodes[index].right_son = right;
+            return rebalance(index);
+        }
+        int left = node.left_son;
+        int right = node.right_son;
+        freeNode(index);
+        if (left == FIXED_TREE_NULL)
+            return right;
+        if (right == FIXED_TREE_NULL)
+            return left;
+        // the successor node itself takes the place of the removed one
+        int successor = FIXED_TREE_NULL;
+        right = removeMinNode(right, successor);
+        nodes[successor].left_son = left;
+        nodes[successor].right_son = right;
+        return rebalance(successor);
+    }
+
+    // adds "amount" to the rank of every node with key < "bound", see Tree::updateCollectorsBelow
+    constexpr void updateCollectorsBelow(int bound, rankType amount) {
+        int index = root;
+        bool added = false;
+        while (index != FIXED_TREE_NULL) {
+            Node &node = nodes[index];
+            if (node.key < bound) {
+                if (!added) {
+                    node.collector += amount;
+                    added = true;
+                }
+                index = node.right_son;
+            }
+            else {
+                if (added) {
+                    node.collector -= amount;
+                    added = false;
+                }
+                index = node.left_son;
+            }
+        }
+    }
+
+    // searches the sub tree of "index", "path_collector" sums the collectors from it down to the key
+    constexpr int findIndex(int index, const keyType key, rankType &path_collector) const {
+        path_collector = rankType();
+        while (index != FIXED_TREE_NULL) {
+            const Node &node = nodes[index];
+            path_collector += node.collector;
+            if (node.key == key)
+                return index;
+            index = key < node.key ? node.left_son : node.right_son;
+        }
+        return FIXED_TREE_NULL;
+    }
+
+    constexpr void exportInorder(int index, keyType *keys, dataType *data, rankType *ranks, int &position,
+                                 rankType current_collector) const {
+        if (index == FIXED_TREE_NULL)
+            return;
+        const Node &node = nodes[index];
+        current_collector += node.collector;
+        exportInorder(node.left_son, keys, data, ranks, position, current_collector);
+        keys[position] = node.key;
+        data[position] = node.data;
+        if (ranks != nullptr)
+            ranks[position] = node.rank + current_collector;
+        position++;
+        exportInorder(node.right_son, keys, data, ranks, position, current_collector);
+    }
+
+    constexpr int buildFromSorted(const keyType *keys, const dataType *data, const rankType *ranks, int first,
+                                  int last) {
+        if (first >= last)
+            return FIXED_TREE_NULL;
+        int middle = first + (last - first) / 2;
+        int index = allocateNode(keys[middle], data[middle], rankType());
+        if (ranks != nullptr)
+            nodes[index].rank = ranks[middle];
+        int left = buildFromSorted(keys, data, ranks, first, middle);
+        int right = buildFromSorted(keys, data, ranks, middle + 1, last);
+        nodes[index].left_son = left;
+        nodes[index].right_son = right;
+        updateHeight(index);
+        return index;
+    }
+
+public:
+    // ----------- TREE PUBLIC FUNCTIONS -----------
+    constexpr FixedTree() : nodes(), root(FIXED_TREE_NULL), used_nodes(0), free_nodes(FIXED_TREE_NULL),
+                            avl_nodes_counter(0) {}
+
+    // returns nullptr if the key does not exist
+    constexpr const Node *find(const keyType key) const {
+        rankType path_collector = rankType();
+        int index = findIndex(root, key, path_collector);
+        return index == FIXED_TREE_NULL ? nullptr : &nodes[index];
+    }
+
+    constexpr Node *find(const keyType key) {
+        rankType path_collector = rankType();
+        int index = findIndex(root, key, path_collector);
+        return index == FIXED_TREE_NULL ? nullptr : &nodes[index];
+    }
+
+    // returns the node of the key, the existing one if the key was already in the tree.
+    // Throws capacityError if the tree is full.
+    constexpr Node *insert(const keyType key, const dataType data) {
+        Node *existing = find(key);
+        if (existing != nullptr)
+            return existing;
+        int inserted = FIXED_TREE_NULL;
+        root = insertNode(root, key, data, rankType(), inserted);
+        return &nodes[inserted];
+    }
+
+    constexpr void remove(const keyType key) {
+        if (find(key) == nullptr)
+            return;
+        root = removeNode(root, key);
+    }
+
+    // upgrade whole keys between "keys_1 <= keys < keys_2" with amount of rankType
+    constexpr void upgradeRank(int key_1, int key_2, rankType amount) {
+        if (key_1 >= key_2)
+            return;
+        updateCollectorsBelow(key_2, amount);
+        updateCollectorsBelow(key_1, rankType() - amount);
+    }
+
+    constexpr const Node *getRoot() const {
+        return getNode(root);
+    }
+
+    // the node of a son index, nullptr for FIXED_TREE_NULL
+    constexpr const Node *getNode(int index) const {
+        return index == FIXED_TREE_NULL ? nullptr : &nodes[index];
+    }
+
+    // the rank of "key" in the sub tree of "node" (the root for a whole tree rank), as Tree::getNodeRank:
+    // "current_collector" is the sum of the collectors above "node"
+    constexpr rankType getNodeRank(const Node *node, const keyType key,
+                                   rankType current_collector = rankType()) const {
+        rankType path_collector = rankType();
+        int index = findIndex(node == nullptr ? FIXED_TREE_NULL : (int) (node - nodes.data()), key, path_collector);
+        return index == FIXED_TREE_NULL ? rankType() : nodes[index].rank + path_collector + current_collector;
+    }
+
+    constexpr rankType getNodeRank(const keyType key) const {
+        return getNodeRank(getRoot(), key);
+    }
+
+    constexpr int getNodeCounter() const {
+        return avl_nodes_counter;
+    }
+
+    static constexpr int getCapacity() {
+        return capacity;
+    }
+
+    // writes keys, data and effective ranks in ascending key order, "ranks" may be nullptr
+    constexpr void exportInorder(keyType *keys, dataType *data, rankType *ranks) const {
+        int position = 0;
+        exportInorder(root, keys, data, ranks, position, rankType());
+    }
+
+    // replaces the content with "size" entries given in strictly ascending key order - O(n)
+    constexpr void buildFromSorted(const keyType *keys, const dataType *data, const rankType *ranks, int size) {
+        if (size > capacity)
+            throw capacityError();
+        root = FIXED_TREE_NULL;
+        used_nodes = 0;
+        free_nodes = FIXED_TREE_NULL;
+        avl_nodes_counter = 0;
+        root = buildFromSorted(keys, data, ranks, 0, size);
+    }
+
+    // -------------- DEBUG FUNCTIONS --------------
+#ifdef DEBUG_ON
+
+    // checks keys order, heights and the AVL condition
+    bool checkInvariants() const {
+        int nodes_counted = 0;
+        return checkInvariants(root, nullptr, nullptr, nodes_counted) != -2 && nodes_counted == avl_nodes_counter;
+    }
+
+    // returns the height of the sub tree, or -2 if any invariant is broken
+    int checkInvariants(int index, const keyType *low, const keyType *high, int &nodes_counted) const {
+        if (index == FIXED_TREE_NULL)
+            return -1;
+        const Node &node = nodes[index];
+        nodes_counted++;
+        if ((low != nullptr && !(*low < node.key)) || (high != nullptr && !(node.key < *high)))
+            return -2;
+        int left_height = checkInvariants(node.left_son, low, &node.key, nodes_counted);
+        int right_height = checkInvariants(node.right_son, &node.key, high, nodes_counted);
+        if (left_height == -2 || right_height == -2 || left_height - right_height > 1 ||
+            right_height - left_height > 1)
+            return -2;
+        int height = (left_height > right_height ? left_height : right_height) + 1;
+        return node.height == height ? height : -2;
+    }
+
+#endif /* DEBUG_ON */
+};
+
+#endif /* AVL_FIXED_RANKED_TREE_H */
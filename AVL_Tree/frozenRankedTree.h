@@ -0,0 +1,119 @@
+#ifndef AVL_FROZEN_RANKED_TREE_H
+#define AVL_FROZEN_RANKED_TREE_H
+
+// -------------------- LIBRARIES --------------------
+#include <new>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+// ------------------ INCLUDE FILES ------------------
+#include "rankedAVLTree.h"
+
+// -------------------- DEFINES --------------------
+#define FROZEN_ALIGNMENT 64 // cache line
+
+// --------------------- READ ME ---------------------
+// Immutable, read optimized copy of a ranked Tree (made by freeze, O(n)), in Eytzinger (BFS) order:
+// slot 1 is the root, the sons of slot k are 2k and 2k + 1, slot 0 stands for "no entry".
+// A search is a branchless descent k = 2k + (key[k] < key) that prefetches the cache line of the
+// descendants 4 levels below, so the pointer chasing of the tree becomes a predictable, prefetched scan.
+// Ranks are stored resolved (no collectors). Keys have to be trivially copyable.
+// Functions: find, lowerBound (slot of the first key >= key), getNodeRank, getKey / getData / getRank of a slot.
+// freeze - the frozen copy of a Tree, with its effective ranks.
+
+// ----------------- FROZEN TREE CLASS -----------------
+template<class keyType, class dataType, class rankType = double>
+class FrozenTree {
+private:
+    struct AlignedDelete {
+        void operator()(keyType *keys) const {
+            operator delete[](keys, std::align_val_t(FROZEN_ALIGNMENT));
+        }
+    };
+
+    int nodes_counter;
+    // cache line aligned, so the descendants 4 levels below slot k (slots 16k .. 16k + 15 for int keys) share a line
+    std::unique_ptr<keyType[], AlignedDelete> keys;
+    std::vector<dataType> data;
+    std::vector<rankType> ranks;
+
+    // fills the sub tree of "slot" with the sorted entries from "next" on
+    void build(const keyType *sorted_keys, const dataType *sorted_data, const rankType *sorted_ranks,
+               int &next, int slot) {
+        if (slot > nodes_counter)
+            return;
+        build(sorted_keys, sorted_data, sorted_ranks, next, 2 * slot);
+        keys[slot] = sorted_keys[next];
+        data[slot] = sorted_data[next];
+        ranks[slot] = sorted_ranks == nullptr ? rankType() : sorted_ranks[next];
+        next++;
+        build(sorted_keys, sorted_data, sorted_ranks, next, 2 * slot + 1);
+    }
+
+public:
+    FrozenTree() : nodes_counter(0) {}
+
+    // "size" entries in strictly ascending key order, "ranks" may be nullptr
+    FrozenTree(const keyType *sorted_keys, const dataType *sorted_data, const rankType *sorted_ranks, int size) :
+            nodes_counter(size), data(size + 1), ranks(size + 1) {
+        static_assert(std::is_trivially_copyable<keyType>::value, "frozen keys must be trivially copyable");
+        keys.reset((keyType *) operator new[]((size + 1) * sizeof(keyType), std::align_val_t(FROZEN_ALIGNMENT)));
+        int next = 0;
+        build(sorted_keys, sorted_data, sorted_ranks, next, 1);
+    }
+
+    int getNodeCounter() const {
+        return nodes_counter;
+    }
+
+    // slot of the smallest key >= "key", 0 if every key is smaller
+    int lowerBound(const keyType key) const {
+        const keyType *slots = keys.get();
+        unsigned int slot = 1;
+        while (slot <= (unsigned int) nodes_counter) {
+            __builtin_prefetch(slots + (size_t) slot * (FROZEN_ALIGNMENT / sizeof(keyType)));
+            slot = 2 * slot + (slots[slot] < key);
+        }
+        // the path went right after the answer every time, drop those steps and the last left step
+        slot >>= __builtin_ffs(~slot);
+        return (int) slot;
+    }
+
+    // returns nullptr if the key does not exist
+    const dataType *find(const keyType key) const {
+        int slot = lowerBound(key);
+        return slot != 0 && !(key < keys[slot]) ? &data[slot] : nullptr;
+    }
+
+    rankType getNodeRank(const keyType key) const {
+        int slot = lowerBound(key);
+        return slot != 0 && !(key < keys[slot]) ? ranks[slot] : rankType();
+    }
+
+    const keyType &getKey(int slot) const {
+        return keys[slot];
+    }
+
+    const dataType &getData(int slot) const {
+        return data[slot];
+    }
+
+    const rankType &getRank(int slot) const {
+        return ranks[slot];
+    }
+};
+
+// ---------------------- FREEZE ----------------------
+template<class keyType, class dataType, class rankType, class balancePolicy, class augmentPolicy, class storagePolicy>
+FrozenTree<keyType, dataType, rankType> freeze(
+        const Tree<keyType, dataType, rankType, balancePolicy, augmentPolicy, storagePolicy> &tree) {
+    int size = tree.getNodeCounter();
+    std::vector<keyType> keys(size);
+    std::vector<dataType> data(size);
+    std::vector<rankType> ranks(size);
+    tree.exportInorder(keys.data(), data.data(), ranks.data());
+    return FrozenTree<keyType, dataType, rankType>(keys.data(), data.data(), ranks.data(), size);
+}
+
+#endif /* AVL_FROZEN_RANKED_TREE_H */
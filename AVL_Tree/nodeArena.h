@@ -0,0 +1,147 @@
+#ifndef AVL_NODE_ARENA_H
+#define AVL_NODE_ARENA_H
+
+// -------------------- LIBRARIES --------------------
+#include <new>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// -------------------- DEFINES --------------------
+#define ARENA_BLOCK_BYTES (1 << 16) // blocks are aligned to their size, so a node finds its block from its address
+#define ARENA_HEADER_BYTES 64 // the first cache line holds the block header, the slots start on the next one
+
+// --------------------- READ ME ---------------------
+// Storage of the nodes that Tree::compact moved: a block holds consecutive node slots, it is freed when its last
+// node is freed and no tree fills it any more (every live node and the filling tree hold one reference).
+// Slots are not reused, a compaction pass always fills fresh blocks in key order.
+// Functions: create, of (the block of a node address), slot, slotsNumber, acquire, release.
+// ArenaStorage - the node storage of a Tree with compact (see NODE STORAGE in rankedAVLTree.h): its State holds
+// the block being filled and the position of the running compaction pass, freeNode frees a heap or an arena node.
+
+class ArenaBlock {
+private:
+    std::atomic<int> references;
+
+    ArenaBlock() : references(1) {}
+
+public:
+    ArenaBlock(const ArenaBlock &other) = delete;
+
+    ArenaBlock &operator=(const ArenaBlock &other) = delete;
+
+    // a new block, referenced once by its creator
+    static ArenaBlock *create() {
+        static_assert(sizeof(ArenaBlock) <= ARENA_HEADER_BYTES, "the block header must fit its cache line");
+        void *memory = operator new(ARENA_BLOCK_BYTES, std::align_val_t(ARENA_BLOCK_BYTES));
+        return new(memory) ArenaBlock();
+    }
+
+    static ArenaBlock *of(const void *address) {
+        return (ArenaBlock *) ((uintptr_t) address & ~(uintptr_t) (ARENA_BLOCK_BYTES - 1));
+    }
+
+    static int slotsNumber(size_t slot_bytes) {
+        return (int) ((ARENA_BLOCK_BYTES - ARENA_HEADER_BYTES) / slot_bytes);
+    }
+
+    void *slot(int index, size_t slot_bytes) {
+        return (char *) this + ARENA_HEADER_BYTES + (size_t) index * slot_bytes;
+    }
+
+    void acquire() {
+        references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // set operations free nodes on several threads, the last release frees the block
+    void release() {
+        if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            this->~ArenaBlock();
+            operator delete(this, std::align_val_t(ARENA_BLOCK_BYTES));
+        }
+    }
+};
+
+// ------------------- ARENA STORAGE -------------------
+struct ArenaStorage {
+    static constexpr bool arena = true;
+    static constexpr bool background = false;
+
+    template<class keyType>
+    class State {
+    public:
+        ArenaBlock *compact_block; // block being filled by compact, nullptr if there is none
+        int compact_block_used;
+        keyType compact_cursor; // biggest key moved by the running compaction pass
+        bool compact_started;
+
+        State() : compact_block(nullptr), compact_block_used(0), compact_cursor(), compact_started(false) {}
+
+        State(const State &other) = delete;
+
+        State &operator=(const State &other) = delete;
+
+        State(State &&other) noexcept: compact_block(other.compact_block),
+                                       compact_block_used(other.compact_block_used),
+                                       compact_cursor(std::move(other.compact_cursor)),
+                                       compact_started(other.compact_started) {
+            other.compact_block = nullptr;
+            other.compact_started = false;
+        }
+
+        State &operator=(State &&other) noexcept {
+            if (this != &other) {
+                releaseBlock();
+                compact_block = other.compact_block;
+                compact_block_used = other.compact_block_used;
+                compact_cursor = std::move(other.compact_cursor);
+                compact_started = other.compact_started;
+                other.compact_block = nullptr;
+                other.compact_started = false;
+            }
+            return *this;
+        }
+
+        ~State() {
+            releaseBlock();
+        }
+
+        void releaseBlock() {
+            if (compact_block != nullptr)
+                compact_block->release();
+            compact_block = nullptr;
+        }
+    };
+
+    template<class nodeType>
+    static void freeNode(nodeType *node) {
+        if (node == nullptr || !node->in_arena) {
+            delete node;
+            return;
+        }
+        ArenaBlock *block = ArenaBlock::of(node);
+        node->~nodeType();
+        block->release();
+    }
+
+    // moves "node" to the next slot of the compaction block, frees it and returns its new address
+    template<class keyType, class nodeType>
+    static nodeType *moveNode(State<keyType> &state, nodeType *node) {
+        static_assert(alignof(nodeType) <= ARENA_HEADER_BYTES && sizeof(nodeType) <= ARENA_BLOCK_BYTES / 16,
+                      "nodes too big for the compaction blocks");
+        if (state.compact_block == nullptr || state.compact_block_used == ArenaBlock::slotsNumber(sizeof(nodeType))) {
+            state.releaseBlock();
+            state.compact_block = ArenaBlock::create();
+            state.compact_block_used = 0;
+        }
+        state.compact_block->acquire();
+        void *slot = state.compact_block->slot(state.compact_block_used++, sizeof(nodeType));
+        nodeType *moved = new(slot) nodeType(std::move(*node));
+        moved->in_arena = true;
+        freeNode(node);
+        return moved;
+    }
+};
+
+#endif /* AVL_NODE_ARENA_H */
@@ -0,0 +1,100 @@
+#ifndef AVL_PARALLEL_SET_OPERATIONS_H
+#define AVL_PARALLEL_SET_OPERATIONS_H
+
+// -------------------- LIBRARIES --------------------
+#include <atomic>
+#include <future>
+#include <thread>
+#include <algorithm>
+
+// ------------------ INCLUDE FILES ------------------
+#include "rankedAVLTree.h"
+
+// --------------------- READ ME ---------------------
+// The join based set operations of a Tree (see Tree::unite) on up to "threads" threads, no more than the
+// hardware threads. The root of one input splits the other and the two pairs of halves are independent: a pair
+// bigger than parallel_grain nodes runs its left half on a new thread while one of the threads is spare, and a
+// thread gives its place back when its half is done, so the splits still to come can use it. At most "threads"
+// threads run at once, however unbalanced the halves are. Smaller pairs run sequentially.
+// Functions: parallelUnite, parallelIntersect, parallelSubtract (same results as unite, intersect, subtract).
+
+template<class treeType>
+class ParallelSetOperations {
+private:
+    typedef typename treeType::Node Node;
+    typedef typename treeType::SetOperation SetOperation;
+
+    static constexpr int parallel_grain = 4096; // smaller pairs of halves run sequentially
+
+    static bool takeThread(std::atomic<int> &spare_threads) {
+        int spare = spare_threads.load(std::memory_order_relaxed);
+        while (spare > 0 && !spare_threads.compare_exchange_weak(spare, spare - 1, std::memory_order_relaxed)) {}
+        return spare > 0;
+    }
+
+    static Node *setOperation(Node *first, Node *second, SetOperation operation, std::atomic<int> &spare_threads) {
+        return treeType::setOperation(first, second, operation, [operation, &spare_threads](
+                Node *first_left, Node *second_left, Node *first_right, Node *second_right, Node *&left,
+                Node *&right) {
+            int nodes = treeType::getSize(first_left) + treeType::getSize(first_right) +
+                        treeType::getSize(second_left) + treeType::getSize(second_right);
+            if (nodes <= parallel_grain) {
+                left = treeType::setOperation(first_left, second_left, operation);
+                right = treeType::setOperation(first_right, second_right, operation);
+            }
+            else if (takeThread(spare_threads)) {
+                std::future<Node *> left_result = std::async(std::launch::async, [=, &spare_threads]() {
+                    Node *result = setOperation(first_left, second_left, operation, spare_threads);
+                    spare_threads.fetch_add(1, std::memory_order_relaxed);
+                    return result;
+                });
+                right = setOperation(first_right, second_right, operation, spare_threads);
+                left = left_result.get();
+            }
+            else {
+                left = setOperation(first_left, second_left, operation, spare_threads);
+                right = setOperation(first_right, second_right, operation, spare_threads);
+            }
+        });
+    }
+
+    static void run(treeType &tree, treeType &other, SetOperation operation, int threads) {
+        int hardware_threads = (int) std::thread::hardware_concurrency(); // 0 if unknown
+        if (hardware_threads > 0)
+            threads = std::min(threads, hardware_threads);
+        std::atomic<int> spare_threads(std::max(threads, 1) - 1);
+        tree.setOperation(other, [operation, &spare_threads](Node *first, Node *second) {
+            return setOperation(first, second, operation, spare_threads);
+        });
+    }
+
+public:
+    static void unite(treeType &tree, treeType &other, int threads) {
+        run(tree, other, treeType::SET_UNION, threads);
+    }
+
+    static void intersect(treeType &tree, treeType &other, int threads) {
+        run(tree, other, treeType::SET_INTERSECTION, threads);
+    }
+
+    static void subtract(treeType &tree, treeType &other, int threads) {
+        run(tree, other, treeType::SET_DIFFERENCE, threads);
+    }
+};
+
+template<class treeType>
+void parallelUnite(treeType &tree, treeType &other, int threads) {
+    ParallelSetOperations<treeType>::unite(tree, other, threads);
+}
+
+template<class treeType>
+void parallelIntersect(treeType &tree, treeType &other, int threads) {
+    ParallelSetOperations<treeType>::intersect(tree, other, threads);
+}
+
+template<class treeType>
+void parallelSubtract(treeType &tree, treeType &other, int threads) {
+    ParallelSetOperations<treeType>::subtract(tree, other, threads);
+}
+
+#endif /* AVL_PARALLEL_SET_OPERATIONS_H */
@@ -0,0 +1,425 @@
+
+// -------------------- LIBRARIES --------------------
+#include <iostream>
+#include <cstdio>
+#include <cstddef>
+#include <vector>
+#include <map>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// -------------------- DEBUG ON! --------------------
+#define DEBUG_ON
+
+// ------------------ INCLUDE FILES ------------------
+#include "../journal.h"
+#include "../bulkLoader.h"
+
+// --------------------- DEFINES ---------------------
+#define SNAPSHOT_PATH "persistence_test_snapshot.bin"
+#define JOURNAL_PATH "persistence_test_journal.bin"
+#define RECORDS_PATH "persistence_test_records.bin"
+
+// --------------------- READ ME ---------------------
+// Tests of the on disk formats: snapshots and journal recovery, written to and read back from the working directory.
+// Journal: a torn tail (half a batch, or a batch with a bad checksum) ends the replay and is cut off, so batches
+// logged after a recovery are replayed by the next one. A batch with a valid checksum but a record that overruns
+// it throws journalError before any record is applied.
+// Checkpoints: a crash between the snapshot and the journal reset replays only the records after the snapshot
+// (upgradeRank is not applied twice), a reset journal keeps its numbering, the hash table skips upgradeRank.
+// Snapshots: a hash table snapshot with corrupted bucket offsets, a tree snapshot with a corrupted node count or
+// a truncated file is rejected with snapshotError, and loading it leaves the structure untouched.
+// Bulk loading: csv and binary files (sorted and unsorted, repeated keys) load into a Tree, a WAVL Tree and a
+// HashTable on 1, 3 and 8 threads like inserts in file order, a malformed line, a truncated binary record or a
+// missing file throws loaderError and leaves the structure untouched.
+// Usage: persistence_test
+
+// appends raw bytes to the journal, as left behind by a crash in the middle of a batch write
+void appendBytes(const char *path, const char *bytes, size_t length) {
+    int fd = open(path, O_WRONLY | O_APPEND);
+    if (fd >= 0) {
+        if (write(fd, bytes, length) != (ssize_t) length)
+            std::cout << "fail (could not write " << path << ")" << std::endl;
+        close(fd);
+    }
+}
+
+// recovers "tree", logs one more durable insert of "key" and recovers again: the insert must survive
+bool recoversAfterTornTail(int key) {
+    Tree<int, int> tree;
+    long long first = recover(tree, SNAPSHOT_PATH, JOURNAL_PATH);
+    {
+        Journal<int, int> journal(JOURNAL_PATH, 1);
+        journal.logInsert(key, key * 10);
+    }
+    Tree<int, int> recovered;
+    long long second = recover(recovered, SNAPSHOT_PATH, JOURNAL_PATH);
+    auto node = recovered.find(key);
+    return second == first + 1 && node != nullptr && node->data == key * 10 && recovered.checkInvariants();
+}
+
+bool checkJournalTornTail() {
+    Tree<int, int> tree;
+    tree.insert(0, 0);
+    saveSnapshot(tree, SNAPSHOT_PATH);
+    remove(JOURNAL_PATH);
+    {
+        Journal<int, int> journal(JOURNAL_PATH, 1);
+        journal.logInsert(1, 10);
+        journal.logInsert(2, 20);
+    }
+
+    // half a batch header
+    JournalBatchHeader header{JOURNAL_BATCH_MAGIC, 64, 0, 0, 0};
+    appendBytes(JOURNAL_PATH, (const char *) &header, sizeof(header) / 2);
+    if (!recoversAfterTornTail(3))
+        return false;
+
+    // a whole batch whose checksum does not match its records
+    char records[9] = {JOURNAL_INSERT};
+    header = JournalBatchHeader{JOURNAL_BATCH_MAGIC, sizeof(records), 0, 1, 5};
+    header.checksum = journalBatchChecksum(header, records) + 1;
+    appendBytes(JOURNAL_PATH, (const char *) &header, sizeof(header));
+    appendBytes(JOURNAL_PATH, records, sizeof(records));
+    if (!recoversAfterTornTail(4))
+        return false;
+
+    // the hash table replays the same (now clean) journal
+    HashTable<int> table;
+    saveSnapshot(table, SNAPSHOT_PATH);
+    if (recover(table, SNAPSHOT_PATH, JOURNAL_PATH) != 4)
+        return false;
+    for (int key = 1; key <= 4; key++) {
+        int *data = table.find(key);
+        if (data == nullptr || *data != key * 10)
+            return false;
+    }
+    return true;
+}
+
+// the ranks (and data) of "tree" must be "ranks" for the keys 1..ranks.size()
+bool hasRanks(Tree<int, int> &tree, const std::vector<double> &ranks) {
+    if (tree.getNodeCounter() != (int) ranks.size() || !tree.checkInvariants())
+        return false;
+    for (int key = 1; key <= (int) ranks.size(); key++) {
+        if (tree.find(key) == nullptr || tree.find(key)->data != key || tree.getNodeRank(key) != ranks[key - 1])
+            return false;
+    }
+    return true;
+}
+
+bool checkJournalCheckpoint() {
+    remove(JOURNAL_PATH);
+    Tree<int, int> tree;
+    uint64_t sequence;
+    {
+        Journal<int, int> journal(JOURNAL_PATH, 3);
+        for (int key = 1; key <= 4; key++) {
+            journal.logInsert(key, key);
+            tree.insert(key, key);
+        }
+        journal.logUpgradeRank(1, 3, 5);
+        tree.upgradeRank(1, 3, 5);
+        // a crash right after the snapshot, before the journal reset
+        journal.sync();
+        saveSnapshot(tree, SNAPSHOT_PATH, journal.getSequence());
+        journal.logUpgradeRank(2, 5, 1);
+        journal.logInsert(5, 5);
+        sequence = journal.getSequence();
+    }
+    Tree<int, int> recovered;
+    if (recover(recovered, SNAPSHOT_PATH, JOURNAL_PATH) != 2 || !hasRanks(recovered, {5, 6, 1, 1, 0}) ||
+        access(SNAPSHOT_PATH ".tmp", F_OK) == 0)
+        return false;
+
+    // a checkpoint, then a reopened journal continues the numbering of the reset one
+    {
+        Journal<int, int> journal(JOURNAL_PATH, 3);
+        if (journal.getSequence() != sequence)
+            return false;
+        journal.checkpoint(recovered, SNAPSHOT_PATH);
+    }
+    {
+        Journal<int, int> journal(JOURNAL_PATH, 3);
+        if (journal.getSequence() != sequence)
+            return false;
+        journal.logUpgradeRank(1, 6, 2);
+        journal.logInsert(6, 6);
+    }
+    Tree<int, int> checkpointed;
+    if (recover(checkpointed, SNAPSHOT_PATH, JOURNAL_PATH) != 2 || !hasRanks(checkpointed, {7, 8, 3, 3, 2, 0}))
+        return false;
+
+    // the hash table skips the upgradeRank records of the same journal
+    HashTable<int> table;
+    saveSnapshot(table, SNAPSHOT_PATH);
+    if (recover(table, SNAPSHOT_PATH, JOURNAL_PATH) != 2 || table.getNodesCounter() != 1 || table.find(6) == nullptr)
+        return false;
+
+    // a batch with a valid checksum whose insert record is cut short: nothing of it is applied
+    char records[] = {JOURNAL_REMOVE, 6, 0, 0, 0, JOURNAL_INSERT, 7, 0};
+    JournalBatchHeader header{JOURNAL_BATCH_MAGIC, sizeof(records), 0, 2, sequence + 3};
+    header.checksum = journalBatchChecksum(header, records);
+    appendBytes(JOURNAL_PATH, (const char *) &header, sizeof(header));
+    appendBytes(JOURNAL_PATH, records, sizeof(records));
+    saveSnapshot(checkpointed, SNAPSHOT_PATH);
+    Tree<int, int> rejected;
+    try {
+        recover(rejected, SNAPSHOT_PATH, JOURNAL_PATH);
+        return false;
+    }
+    catch (const journalError &) {}
+    return hasRanks(rejected, {7, 8, 3, 3, 2, 0});
+}
+
+// overwrites "length" bytes of the file at "offset"
+void patchBytes(const char *path, long offset, const void *bytes, size_t length) {
+    FILE *file = fopen(path, "r+b");
+    if (file == nullptr || fseek(file, offset, SEEK_SET) != 0 || fwrite(bytes, 1, length, file) != length)
+        std::cout << "fail (could not patch " << path << ")" << std::endl;
+    if (file != nullptr)
+        fclose(file);
+}
+
+// the view and loadSnapshot of the snapshot file must throw, and the loaded table must keep its content
+bool rejectsSnapshot() {
+    try {
+        HashTableSnapshotView<int> view(SNAPSHOT_PATH);
+        return false;
+    }
+    catch (const snapshotError &) {}
+    HashTable<int> table;
+    table.insert(-1, 1);
+    try {
+        loadSnapshot(table, SNAPSHOT_PATH);
+        return false;
+    }
+    catch (const snapshotError &) {}
+    return table.getNodesCounter() == 1 && table.find(-1) != nullptr;
+}
+
+bool checkCorruptSnapshot() {
+    HashTable<int> table;
+    for (int key = 0; key < 100; key++)
+        table.insert(key, key);
+    saveSnapshot(table, SNAPSHOT_PATH);
+    HashTableSnapshotView<int> view(SNAPSHOT_PATH);
+    int hash_size = view.getHashSize();
+    long offsets = (long) snapshotAlign(sizeof(SnapshotHeader));
+    std::vector<uint64_t> bucket_offsets(view.getBucketOffsets(), view.getBucketOffsets() + hash_size + 1);
+
+    // an offset out of the key section, then an offset below the previous one
+    uint64_t out_of_range = bucket_offsets[hash_size] + 1000;
+    patchBytes(SNAPSHOT_PATH, offsets + sizeof(uint64_t), &out_of_range, sizeof(uint64_t));
+    if (!rejectsSnapshot())
+        return false;
+    uint64_t decreasing = bucket_offsets[hash_size / 2] - 1;
+    patchBytes(SNAPSHOT_PATH, offsets + sizeof(uint64_t), &bucket_offsets[1], sizeof(uint64_t));
+    patchBytes(SNAPSHOT_PATH, offsets + (hash_size / 2 + 1) * sizeof(uint64_t), &decreasing, sizeof(uint64_t));
+    if (bucket_offsets[hash_size / 2] == 0 || !rejectsSnapshot())
+        return false;
+
+    // a file cut in the middle of its sections
+    saveSnapshot(table, SNAPSHOT_PATH);
+    if (truncate(SNAPSHOT_PATH, offsets + (hash_size + 1) * sizeof(uint64_t) + 10) != 0 || !rejectsSnapshot())
+        return false;
+    return true;
+}
+
+void writeFile(const char *path, const std::string &content) {
+    FILE *file = fopen(path, "wb");
+    if (file == nullptr || fwrite(content.data(), 1, content.size(), file) != content.size())
+        std::cout << "fail (could not write " << path << ")" << std::endl;
+    if (file != nullptr)
+        fclose(file);
+}
+
+std::string binaryRecords(const std::vector<std::pair<int, int>> &records) {
+    std::string content;
+    for (const auto &record: records) {
+        content.append((const char *) &record.first, sizeof(int));
+        content.append((const char *) &record.second, sizeof(int));
+    }
+    return content;
+}
+
+template<class rankType, class balancePolicy, class augmentPolicy, class storagePolicy>
+bool matches(Tree<int, int, rankType, balancePolicy, augmentPolicy, storagePolicy> &tree, const std::map<int, int> &expected) {
+    if (tree.getNodeCounter() != (int) expected.size() || !tree.checkInvariants())
+        return false;
+    for (const auto &entry: expected) {
+        auto node = tree.find(entry.first);
+        if (node == nullptr || node->data != entry.second)
+            return false;
+    }
+    return true;
+}
+
+bool matches(HashTable<int> &table, const std::map<int, int> &expected) {
+    if (table.getNodesCounter() != (int) expected.size())
+        return false;
+    for (const auto &entry: expected) {
+        int *data = table.find(entry.first);
+        if (data == nullptr || *data != entry.second)
+            return false;
+    }
+    return true;
+}
+
+// loads the records file on every thread count, the structure must hold "expected"
+template<class structureType>
+bool loadsRecords(LoaderFormat format, const std::map<int, int> &expected) {
+    for (int threads: {1, 3, 8}) {
+        structureType structure;
+        structure.insert(INT_MIN, 0); // replaced by the load
+        bulkLoad(structure, RECORDS_PATH, format, threads);
+        if (!matches(structure, expected))
+            return false;
+    }
+    return true;
+}
+
+// loading the records file must throw and keep the structure content
+template<class structureType>
+bool rejectsRecords(LoaderFormat format) {
+    structureType structure;
+    structure.insert(-1, 1);
+    try {
+        bulkLoad(structure, RECORDS_PATH, format, 3);
+        return false;
+    }
+    catch (const loaderError &) {}
+    return matches(structure, std::map<int, int>{{-1, 1}});
+}
+
+bool loadsAll(LoaderFormat format, const std::map<int, int> &expected) {
+    return loadsRecords<Tree<int, int>>(format, expected) &&
+           loadsRecords<Tree<int, int, double, WAVLBalance>>(format, expected) &&
+           loadsRecords<HashTable<int>>(format, expected);
+}
+
+bool rejectsAll(LoaderFormat format) {
+    return rejectsRecords<Tree<int, int>>(format) && rejectsRecords<Tree<int, int, double, WAVLBalance>>(format) &&
+           rejectsRecords<HashTable<int>>(format);
+}
+
+bool checkBulkLoad() {
+    // sorted and unsorted records, with repeated keys: the first record of a key wins
+    std::vector<std::vector<std::pair<int, int>>> files;
+    std::vector<std::pair<int, int>> records;
+    for (int key = -500; key < 500; key++)
+        records.emplace_back(key * 3, key);
+    files.push_back(records);
+    for (int i = 0; i < 2000; i++)
+        records.emplace_back((i * 7919) % 1201 - 600, i);
+    files.push_back(records);
+
+    for (const auto &file_records: files) {
+        std::map<int, int> expected;
+        std::string csv;
+        for (size_t i = 0; i < file_records.size(); i++) {
+            expected.insert(file_records[i]);
+            csv += std::to_string(file_records[i].first) + "," + std::to_string(file_records[i].second);
+            csv += i % 5 == 0 ? "\r\n" : (i % 7 == 0 ? "\n\n" : "\n");
+        }
+        csv.pop_back(); // a last line without its line end
+        writeFile(RECORDS_PATH, csv);
+        if (!loadsAll(LOADER_CSV, expected))
+            return false;
+        writeFile(RECORDS_PATH, binaryRecords(file_records));
+        if (!loadsAll(LOADER_BINARY, expected))
+            return false;
+    }
+
+    // empty files load as empty structures
+    writeFile(RECORDS_PATH, "");
+    if (!loadsAll(LOADER_CSV, {}) || !loadsAll(LOADER_BINARY, {}))
+        return false;
+    writeFile(RECORDS_PATH, "\n\r\n");
+    if (!loadsAll(LOADER_CSV, {}))
+        return false;
+
+    // malformed csv lines, anywhere in the file
+    for (const char *line: {"3;4", "1,", ",5", "1,2x", "x", "99999999999,1", "1,2,3"}) {
+        for (int place = 0; place < 3; place++) {
+            std::string csv;
+            for (int key = 0; key < 100; key++) {
+                if (key == place * 49)
+                    csv += std::string(line) + "\n";
+                csv += std::to_string(key) + "," + std::to_string(key) + "\n";
+            }
+            writeFile(RECORDS_PATH, csv);
+            if (!rejectsAll(LOADER_CSV))
+                return false;
+        }
+    }
+
+    // a truncated binary record, then a missing file
+    std::string binary = binaryRecords(files[0]);
+    binary.pop_back();
+    writeFile(RECORDS_PATH, binary);
+    if (!rejectsAll(LOADER_BINARY))
+        return false;
+    remove(RECORDS_PATH);
+    return rejectsAll(LOADER_CSV) && rejectsAll(LOADER_BINARY);
+}
+
+// the tree view and loadSnapshot of the snapshot file must throw, and the loaded tree must keep its content
+bool rejectsTreeSnapshot() {
+    try {
+        TreeSnapshotView<int, int> view(SNAPSHOT_PATH);
+        return false;
+    }
+    catch (const snapshotError &) {}
+    Tree<int, int> tree;
+    tree.insert(-1, 1);
+    try {
+        loadSnapshot(tree, SNAPSHOT_PATH);
+        return false;
+    }
+    catch (const snapshotError &) {}
+    return tree.getNodeCounter() == 1 && tree.find(-1) != nullptr && tree.checkInvariants();
+}
+
+bool checkCorruptTreeSnapshot() {
+    Tree<int, int> tree;
+    for (int key = 0; key < 100; key++)
+        tree.insert(key, key);
+    long nodes_counter_offset = (long) offsetof(SnapshotHeader, nodes_counter);
+
+    // node counts whose section sizes overflow, or that need more sections than the file holds
+    for (uint64_t nodes_counter: {(1ULL << 61) + 5, (1ULL << 31), 101ULL}) {
+        saveSnapshot(tree, SNAPSHOT_PATH);
+        patchBytes(SNAPSHOT_PATH, nodes_counter_offset, &nodes_counter, sizeof(uint64_t));
+        if (!rejectsTreeSnapshot())
+            return false;
+    }
+
+    // a file cut in the middle of its data section
+    saveSnapshot(tree, SNAPSHOT_PATH);
+    struct stat file_stat{};
+    if (stat(SNAPSHOT_PATH, &file_stat) != 0 || truncate(SNAPSHOT_PATH, file_stat.st_size - 10) != 0)
+        return false;
+    return rejectsTreeSnapshot();
+}
+
+int main() {
+    std::cout << "Journal torn tail recovery and checkpoints: ";
+    bool journal_passed = checkJournalTornTail() && checkJournalCheckpoint();
+    std::cout << (journal_passed ? "pass" : "fail") << std::endl;
+
+    std::cout << "Corrupted hash table and tree snapshots: ";
+    bool snapshot_passed = checkCorruptSnapshot() && checkCorruptTreeSnapshot();
+    std::cout << (snapshot_passed ? "pass" : "fail") << std::endl;
+
+    std::cout << "Bulk loading of csv and binary records: ";
+    bool bulk_load_passed = checkBulkLoad();
+    std::cout << (bulk_load_passed ? "pass" : "fail") << std::endl;
+
+    remove(SNAPSHOT_PATH);
+    remove(JOURNAL_PATH);
+    remove(RECORDS_PATH);
+    return journal_passed && snapshot_passed && bulk_load_passed ? 0 : 1;
+}
@@ -0,0 +1,378 @@
+#ifndef AVL_PERSISTENT_RANKED_TREE_H
+#define AVL_PERSISTENT_RANKED_TREE_H
+
+// -------------------- LIBRARIES --------------------
+#include <iostream>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+
+// ------------------ INCLUDE FILES ------------------
+#include "treeStats.h"
+
+// --------------------- READ ME ---------------------
+// Persistent (versioned) AVL ranked tree, same rank semantics as Tree in rankedAVLTree.h:
+// node rank = its own rank + the collectors on the path from the root down to it, rankType as in Tree.
+// Nodes are immutable and shared between versions. An update copies only the nodes on its path
+// (and O(1) nodes per rotation, for the collector moves), so it allocates O(log n) nodes.
+// snapshot() / copy construction share the root - O(1). Nodes are reference counted (atomic counters),
+// a node is freed with the last version that reaches it.
+// One PersistentTree object is not thread safe, but different versions can be used by different threads.
+// Functions: init, insert, remove, find, upgradeRank, getNodeRank, snapshot, exportInorder, buildFromSorted.
+
+// ------------- PERSISTENT AVL TREE CLASS -------------
+template<class keyType, class dataType, class rankType = double>
+class PersistentTree {
+private:
+
+    class Node {
+    public:
+        const keyType key;
+        const dataType data;
+        const rankType collector; // collector to calculate node rank from root to node
+        const rankType rank;
+        const int height;
+        const int size; // number of nodes in the sub tree
+        const Node *const left_son;
+        const Node *const right_son;
+        mutable std::atomic<int> references;
+
+        Node(const keyType key, const dataType data, rankType collector, rankType rank, const Node *left_son,
+             const Node *right_son) : key(key), data(data), collector(collector), rank(rank),
+                                      height(std::max(getHeight(left_son), getHeight(right_son)) + 1),
+                                      size(getSize(left_son) + getSize(right_son) + 1), left_son(left_son),
+                                      right_son(right_son), references(1) {
+            acquire(left_son);
+            acquire(right_son);
+            AVL_STATS_ADD(STATS_ALLOCATIONS, 1);
+        }
+
+#ifdef AVL_STATS_ON
+        ~Node() {
+            AVL_STATS_ADD(STATS_DEALLOCATIONS, 1);
+        }
+#endif /* AVL_STATS_ON */
+    };
+
+    const Node *root;
+
+    // ----------- TREE PRIVATE FUNCTIONS -----------
+    static int getHeight(const Node *node) {
+        return node == nullptr ? -1 : node->height;
+    }
+
+    static int getSize(const Node *node) {
+        return node == nullptr ? 0 : node->size;
+    }
+
+    static const Node *acquire(const Node *node) {
+        if (node != nullptr)
+            node->references.fetch_add(1, std::memory_order_relaxed);
+        return node;
+    }
+
+    static void release(const Node *node) {
+        if (node != nullptr && node->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            const Node *left_son = node->left_son;
+            const Node *right_son = node->right_son;
+            delete node;
+            release(left_son);
+            release(right_son);
+        }
+    }
+
+    // new owned node, the sons are borrowed (the node takes its own references)
+    static const Node *makeNode(const Node *fields, rankType collector, const Node *left, const Node *right) {
+        return new Node(fields->key, fields->data, collector, fields->rank, left, right);
+    }
+
+    static const Node *makeNode(const keyType key, const dataType data, rankType rank, rankType collector,
+                                const Node *left, const Node *right) {
+        return new Node(key, data, collector, rank, left, right);
+    }
+
+    // owned copy of "node" whose collector is bigger by "amount" (shares the sons)
+    static const Node *addCollector(const Node *node, rankType amount) {
+        if (node == nullptr || amount == 0)
+            return acquire(node);
+        return makeNode(node, node->collector + amount, node->left_son, node->right_son);
+    }
+
+    // rotations of a borrowed node, the collectors are moved so every rank stays the same
+    static const Node *LLrotate(const Node *father) {
+        const Node *son = father->left_son;
+        const Node *moved = addCollector(son->right_son, son->collector);
+        const Node *new_father = makeNode(father, -son->collector, moved, father->right_son);
+        const Node *new_root = makeNode(son, father->collector + son->collector, son->left_son, new_father);
+        release(moved);
+        release(new_father);
+        return new_root;
+    }
+
+    static const Node *RRrotate(const Node *father) {
+        const Node *son = father->right_son;
+        const Node *moved = addCollector(son->left_son, son->collector);
+        const Node *new_father = makeNode(father, -son->collector, father->left_son, moved);
+        const Node *new_root = makeNode(son, father->collector + son->collector, new_father, son->right_son);
+        release(moved);
+        release(new_father);
+        return new_root;
+    }
+
+    // owned node with the fields of "fields" over the borrowed sons, AVL balanced
+    static const Node *makeBalanced(const Node *fields, rankType collector, const Node *left, const Node *right) {
+        return makeBalanced(fields->key, fields->data, fields->rank, collector, left, right);
+    }
+
+    static const Node *makeBalanced(const keyType key, const dataType data, rankType rank, rankType collector,
+                                    const Node *left, const Node *right) {
+        int balance = getHeight(left) - getHeight(right);
+        const Node *node;
+        if (balance > 1 && getHeight(left->left_son) < getHeight(left->right_son)) { // LR ROTATE
+            AVL_STATS_ADD(STATS_LR_ROTATIONS, 1);
+            const Node *rotated_left = RRrotate(left);
+            node = makeNode(key, data, rank, collector, rotated_left, right);
+            release(rotated_left);
+        }
+        else if (balance < -1 && getHeight(right->right_son) < getHeight(right->left_son)) { // RL ROTATE
+            AVL_STATS_ADD(STATS_RL_ROTATIONS, 1);
+            const Node *rotated_right = LLrotate(right);
+            node = makeNode(key, data, rank, collector, left, rotated_right);
+            release(rotated_right);
+        }
+        else {
+            node = makeNode(key, data, rank, collector, left, right);
+            if (balance > 1)
+                AVL_STATS_ADD(STATS_LL_ROTATIONS, 1);
+            else if (balance < -1)
+                AVL_STATS_ADD(STATS_RR_ROTATIONS, 1);
+        }
+        if (abs(balance) <= 1)
+            return node;
+        const Node *rotated = balance > 1 ? LLrotate(node) : RRrotate(node);
+        release(node);
+        return rotated;
+    }
+
+    static const Node *insertNode(const Node *node, const keyType key, const dataType data,
+                                  rankType current_collector) {
+        if (node == nullptr)
+            return makeNode(key, data, 0, -current_collector, nullptr, nullptr); // starts with rank 0
+        current_collector += node->collector;
+        const Node *left = node->left_son;
+        const Node *right = node->right_son;
+        if (key < node->key)
+            left = insertNode(left, key, data, current_collector);
+        else
+            right = insertNode(right, key, data, current_collector);
+        const Node *new_node = makeBalanced(node, node->collector, left, right);
+        release(key < node->key ? left : right);
+        return new_node;
+    }
+
+    // detaches the minimum: returns the new sub tree and the minimum node with its rank relative to "node"
+    static const Node *removeMinNode(const Node *node, const Node *&min_node, rankType &min_rank) {
+        if (node->left_son == nullptr) {
+            min_node = node;
+            min_rank = node->collector + node->rank;
+            return addCollector(node->right_son, node->collector);
+        }
+        const Node *left = removeMinNode(node->left_son, min_node, min_rank);
+        min_rank += node->collector;
+        const Node *new_node = makeBalanced(node, node->collector, left, node->right_son);
+        release(left);
+        return new_node;
+    }
+
+    static const Node *removeNode(const Node *node, const keyType key) {
+        if (node->key == key) {
+            if (node->left_son == nullptr)
+                return addCollector(node->right_son, node->collector);
+            if (node->right_son == nullptr)
+                return addCollector(node->left_son, node->collector);
+            // the successor takes the place of the node, with its rank expressed below the node collector
+            const Node *successor;
+            rankType successor_rank;
+            const Node *right = removeMinNode(node->right_son, successor, successor_rank);
+            const Node *new_node = makeBalanced(successor->key, successor->data, successor_rank, node->collector,
+                                                node->left_son, right);
+            release(right);
+            return new_node;
+        }
+        const Node *left = node->left_son;
+        const Node *right = node->right_son;
+        if (key < node->key)
+            left = removeNode(left, key);
+        else
+            right = removeNode(right, key);
+        const Node *new_node = makeBalanced(node, node->collector, left, right);
+        release(key < node->key ? left : right);
+        return new_node;
+    }
+
+    // path copy that adds "amount" to the rank of every node with key < "bound", see Tree::updateCollectorsBelow
+    static const Node *updateCollectorsBelow(const Node *node, int bound, rankType amount, bool added) {
+        if (node == nullptr)
+            return nullptr;
+        rankType collector = node->collector;
+        const Node *left = node->left_son;
+        const Node *right = node->right_son;
+        if (node->key < bound) {
+            if (!added)
+                collector += amount;
+            right = updateCollectorsBelow(right, bound, amount, true);
+            const Node *new_node = makeNode(node, collector, left, right);
+            release(right);
+            return new_node;
+        }
+        if (added)
+            collector -= amount;
+        left = updateCollectorsBelow(left, bound, amount, false);
+        const Node *new_node = makeNode(node, collector, left, right);
+        release(left);
+        return new_node;
+    }
+
+    const Node *findNode(const keyType key, rankType &path_collector) const {
+        const Node *node = root;
+        path_collector = 0;
+        while (node != nullptr) {
+            path_collector += node->collector;
+            if (node->key == key)
+                return node;
+            node = key < node->key ? node->left_son : node->right_son;
+        }
+        return nullptr;
+    }
+
+    static const Node *buildFromSorted(const keyType *keys, const dataType *data, const rankType *ranks, int first,
+                                       int last) {
+        if (first >= last)
+            return nullptr;
+        int middle = first + (last - first) / 2;
+        const Node *left = buildFromSorted(keys, data, ranks, first, middle);
+        const Node *right = buildFromSorted(keys, data, ranks, middle + 1, last);
+        const Node *node = makeNode(keys[middle], data[middle], ranks == nullptr ? 0 : ranks[middle], 0, left,
+                                    right);
+        release(left);
+        release(right);
+        return node;
+    }
+
+    static void exportInorder(const Node *node, keyType *keys, dataType *data, rankType *ranks, int &index,
+                              rankType current_collector) {
+        if (node == nullptr)
+            return;
+        current_collector += node->collector;
+        exportInorder(node->left_son, keys, data, ranks, index, current_collector);
+        keys[index] = node->key;
+        data[index] = node->data;
+        if (ranks != nullptr)
+            ranks[index] = node->rank + current_collector;
+        index++;
+        exportInorder(node->right_son, keys, data, ranks, index, current_collector);
+    }
+
+    void replaceRoot(const Node *new_root) {
+        release(root);
+        root = new_root;
+    }
+
+public:
+    // ----------- TREE PUBLIC FUNCTIONS -----------
+    PersistentTree() : root(nullptr) {}
+
+    ~PersistentTree() {
+        release(root);
+    }
+
+    // O(1): both versions share every node
+    PersistentTree(const PersistentTree &other) : root(acquire(other.root)) {}
+
+    PersistentTree &operator=(const PersistentTree &other) {
+        if (this != &other)
+            replaceRoot(acquire(other.root));
+        return *this;
+    }
+
+    PersistentTree snapshot() const {
+        return PersistentTree(*this);
+    }
+
+    int getNodeCounter() const {
+        return getSize(root);
+    }
+
+    // returns nullptr if the key does not exist
+    const dataType *find(const keyType key) const {
+        rankType path_collector;
+        const Node *node = findNode(key, path_collector);
+        return node == nullptr ? nullptr : &node->data;
+    }
+
+    rankType getNodeRank(const keyType key) const {
+        rankType path_collector;
+        const Node *node = findNode(key, path_collector);
+        return node == nullptr ? rankType() : node->rank + path_collector;
+    }
+
+    void insert(const keyType key, const dataType data) {
+        if (find(key) != nullptr)
+            return;
+        replaceRoot(insertNode(root, key, data, 0));
+    }
+
+    void remove(const keyType key) {
+        if (find(key) == nullptr)
+            return;
+        replaceRoot(removeNode(root, key));
+    }
+
+    // upgrade whole keys between "keys_1 <= keys < keys_2" with amount of rankType
+    void upgradeRank(int key_1, int key_2, rankType amount) {
+        if (key_1 >= key_2)
+            return;
+        replaceRoot(updateCollectorsBelow(root, key_2, amount, false));
+        replaceRoot(updateCollectorsBelow(root, key_1, -amount, false));
+    }
+
+    // writes keys, data and effective ranks in ascending key order, "ranks" may be nullptr
+    void exportInorder(keyType *keys, dataType *data, rankType *ranks) const {
+        int index = 0;
+        exportInorder(root, keys, data, ranks, index, 0);
+    }
+
+    // replaces the content with "size" entries given in strictly ascending key order - O(n)
+    void buildFromSorted(const keyType *keys, const dataType *data, const rankType *ranks, int size) {
+        replaceRoot(buildFromSorted(keys, data, ranks, 0, size));
+    }
+
+    // -------------- DEBUG FUNCTIONS --------------
+#ifdef DEBUG_ON
+
+    // checks keys order, heights, sizes and the AVL condition of this version
+    bool checkInvariants() const {
+        return checkInvariants(root, nullptr, nullptr) != -2;
+    }
+
+    // returns the height of the sub tree, or -2 if any invariant is broken
+    int checkInvariants(const Node *node, const keyType *low, const keyType *high) const {
+        if (node == nullptr)
+            return -1;
+        if ((low != nullptr && !(*low < node->key)) || (high != nullptr && !(node->key < *high)))
+            return -2;
+        int left_height = checkInvariants(node->left_son, low, &node->key);
+        int right_height = checkInvariants(node->right_son, &node->key, high);
+        if (left_height == -2 || right_height == -2 || abs(left_height - right_height) > 1)
+            return -2;
+        int height = std::max(left_height, right_height) + 1;
+        if (node->height != height || node->size != getSize(node->left_son) + getSize(node->right_son) + 1 ||
+            node->references.load() < 1)
+            return -2;
+        return height;
+    }
+
+#endif /* DEBUG_ON */
+};
+
+#endif /* AVL_PERSISTENT_RANKED_TREE_H */
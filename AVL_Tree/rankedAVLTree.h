@@ -3,9 +3,14 @@
 
 // -------------------- LIBRARIES --------------------
 #include <iostream>
+#include <vector>
+#include <utility>
+#include <queue>
 #include <exception>
 #include <cassert>
 
+// ------------------ INCLUDE FILES ------------------
+#include "treeStats.h"
 
 // ----------------- ROTATE EXCEPTION -----------------
 class rotateError : public std::exception {
@@ -15,37 +20,147 @@ public:
     }
 };
 
+// ------------------ JOIN EXCEPTION ------------------
+class joinError : public std::exception {
+public:
+    const char *what() const noexcept override {
+        return "Join Error";
+    }
+};
+
+// ----------------- BALANCE POLICIES -----------------
+// The balancing scheme of a Tree, its last template parameter.
+// AVLBalance - sibling heights differ by at most 1 (height <= 1.44 log n). A remove may rotate on every level.
+// WAVLBalance - weak AVL: every rank difference between a node and its son is 1 or 2 and every leaf has rank 0
+// (height <= 2 log n, and an insert only tree stays AVL). An insert or a remove does at most 2 rotations,
+// the rank changes above them are O(1) amortized. split, join, removeRange and the set operations need AVL.
+struct AVLBalance {
+    static constexpr bool weak = false;
+    static constexpr const char *name = "avl";
+};
+
+struct WAVLBalance {
+    static constexpr bool weak = true;
+    static constexpr const char *name = "wavl";
+};
+
+// --------------- RANK AUGMENTATIONS ----------------
+// What every node of a Tree keeps about the ranks of its sub tree, the template parameter after the balance.
+// NoRankAugment (default) - nothing, topK is not available.
+// MaxRankAugment - the max rank of the sub tree (one more rankType per node, fixed on every structure change and
+// on the upgradeRank paths), for topK.
+struct NoRankAugment {
+    static constexpr bool max_rank = false;
+};
+
+struct MaxRankAugment {
+    static constexpr bool max_rank = true;
+};
+
+// the max rank field of a node, empty without the augmentation
+template<class rankType, bool augmented>
+struct NodeMaxRank {
+    rankType value;
+};
+
+template<class rankType>
+struct NodeMaxRank<rankType, false> {
+};
+
+// ------------------- NODE STORAGE -------------------
+// Where the nodes of a Tree live and who frees them, the template parameter after the augmentation.
+// HeapStorage (default) - one heap allocation per node, freed by the thread that removes it.
+// ArenaStorage (nodeArena.h) - adds compact, which moves the nodes into contiguous blocks.
+// BackgroundStorage (backgroundReclaimer.h) - adds setBackgroundDestruction, old nodes go to a reclaimer thread.
+// A storage has the arena / background flags and a State kept in every tree (empty for HeapStorage), the
+// functions behind the flags live in the storage header, so the Tree itself starts no thread and owns no block.
+struct HeapStorage {
+    static constexpr bool arena = false;
+    static constexpr bool background = false;
+
+    template<class keyType>
+    struct State {
+    };
+};
+
+// runs the set operations of a Tree on several threads, see parallelSetOperations.h
+template<class treeType>
+class ParallelSetOperations;
+
 // --------------------- READ ME ---------------------
 // This templated AVL ranked tree.
+// rankType - type of the ranks and of the upgradeRank amounts, double by default. Integer types (int64_t)
+// and FixedPoint (fixedPoint.h) keep the ranks exact, it needs 0 construction, +, -, == and <.
 // Functions:
 // init, insert, remove, find, getRoot - get root node of the tree, getNodeRank.
-// upgradeRank - upgrade whole keys between "keys_1 <= keys < keys_2" with amount of double.
+// exportInorder / buildFromSorted - dump the tree to sorted arrays and rebuild it from them (or from a sorted
+// stream of entries, without arrays) in O(n).
+// upgradeRank - upgrade whole keys between "keys_1 <= keys < keys_2" with amount of rankType.
+// getNodeRank - node rank = its own rank + the collectors on the path from the root down to it.
+// split - cut the tree at a key, join - concatenate two trees with disjoint key ranges, both O(log n).
+// removeRange - remove the keys in [lo, hi) with two splits and a join, O(log n + k).
+// topK - the k entries with the highest ranks, in descending rank order, O(k log k) best first search
+// (with MaxRankAugment only).
+// unite, intersect, subtract - join based set operations with "other" (on several threads with
+// parallelSetOperations.h).
+// compact (ArenaStorage only) - moves a bounded number of nodes, in key order, into contiguous blocks (see
+// nodeArena.h), so an idle loop restores the locality that insert / remove churn scattered. It moves nodes: Node
+// pointers become invalid.
+// setBackgroundDestruction (BackgroundStorage only) - opt-in, the destructor, a move assignment and
+// buildFromSorted hand the old nodes to the BackgroundReclaimer thread (see backgroundReclaimer.h) instead of
+// freeing them one by one, O(1).
+// An immutable Eytzinger layout copy for read only lookups is made by freeze (see frozenRankedTree.h).
+// balancePolicy - AVLBalance (default) or WAVLBalance, for fewer rotations on remove heavy workloads.
+// augmentPolicy - NoRankAugment (default) or MaxRankAugment, for topK. The node is 56 bytes without it and 64
+// with it (int keys, data and double ranks), the trees inside the hash buckets stay without it.
+// storagePolicy - HeapStorage (default), ArenaStorage or BackgroundStorage, see NODE STORAGE.
+// With AVL_STATS_ON: getHeight, getMemoryBytes, dumpStats (see treeStats.h).
 
 // ------------------ AVL TREE CLASS ------------------
-template<class keyType, class dataType>
+template<class keyType, class dataType, class rankType = double, class balancePolicy = AVLBalance,
+        class augmentPolicy = NoRankAugment, class storagePolicy = HeapStorage>
 class Tree {
-private:
+    friend class ParallelSetOperations<Tree>;
+
+public:
 
+    // a node keeps its key and data for its whole life (remove relinks nodes, it never copies them),
+    // so a Node pointer is a stable handle until its key is removed or the tree is compacted:
+    // compact moves the nodes, every Node pointer held across it dangles.
     class Node {
     public:
         keyType key;
         dataType data;
-        double collector; // collector to calculate node rank from root to node
-        double rank;
-        int height;
+        rankType collector; // collector to calculate node rank from root to node
+        rankType rank;
+        int height; // the rank with WAVLBalance
         int balance; // positive if left higher
+        int size; // number of nodes in the sub tree
+        bool in_arena; // moved by compact into an arena block, ArenaStorage only
+        // max rank in the sub tree, with the collectors below this node (not its own). Empty without MaxRankAugment
+        NodeMaxRank<rankType, augmentPolicy::max_rank> max_rank;
         Node *left_son;
         Node *right_son;
 
         explicit Node(const keyType key, const dataType data) : key(key), data(data), collector(0), rank(0),
-                                                                height(0), balance(0), left_son(nullptr),
-                                                                right_son(nullptr) {}
+                                                                height(0), balance(0), size(1), in_arena(false),
+                                                                max_rank(), left_son(nullptr), right_son(nullptr) {
+            if constexpr (augmentPolicy::max_rank)
+                max_rank.value = 0;
+            AVL_STATS_ADD(STATS_ALLOCATIONS, 1);
+        }
+
+#ifdef AVL_STATS_ON
+        ~Node() {
+            AVL_STATS_ADD(STATS_DEALLOCATIONS, 1);
+        }
+#endif /* AVL_STATS_ON */
 
-        void updateRank(double increase_rank) {
+        void updateRank(rankType increase_rank) {
             this->rank += increase_rank;
         }
 
-        void updateCollector(double increase_collector) {
+        void updateCollector(rankType increase_collector) {
             this->collector += increase_collector;
         }
 
@@ -53,6 +168,19 @@ private:
             this->collector = 0;
         }
 
+        // moves the pending collector into the node rank and down to its sons
+        void pushCollector() {
+            if (collector == 0)
+                return;
+            if (left_son != nullptr)
+                left_son->updateCollector(collector);
+            if (right_son != nullptr)
+                right_son->updateCollector(collector);
+            updateRank(collector);
+            addMaxRank(collector);
+            resetCollector();
+        }
+
         void updateBalance() {
             int left_son_height = getSonHeight(left_son);
             int right_son_height = getSonHeight(right_son);
@@ -68,25 +196,83 @@ private:
                 height = right_son_height + 1;
         }
 
+        void updateSize() {
+            size = getSonSize(left_son) + getSonSize(right_son) + 1;
+        }
+
+        rankType getSubTreeMaxRank() const {
+            rankType sub_tree_max = rank;
+            if (left_son != nullptr && sub_tree_max < left_son->max_rank.value + left_son->collector)
+                sub_tree_max = left_son->max_rank.value + left_son->collector;
+            if (right_son != nullptr && sub_tree_max < right_son->max_rank.value + right_son->collector)
+                sub_tree_max = right_son->max_rank.value + right_son->collector;
+            return sub_tree_max;
+        }
+
+        // the max rank functions do nothing without MaxRankAugment
+        void updateMaxRank() {
+            if constexpr (augmentPolicy::max_rank)
+                max_rank.value = getSubTreeMaxRank();
+        }
+
+        void addMaxRank(rankType increase_max_rank) {
+            if constexpr (augmentPolicy::max_rank)
+                max_rank.value += increase_max_rank;
+        }
+
+        bool checkMaxRank() const {
+            if constexpr (augmentPolicy::max_rank)
+                return max_rank.value == getSubTreeMaxRank();
+            return true;
+        }
+
+        int getSonSize(const Node *child) const {
+            return child == nullptr ? 0 : child->size;
+        }
+
         int getSonHeight(const Node *child) const {
             return child == nullptr ? -1 : child->height;
         }
     };
 
+private:
     Node *root;
     int avl_nodes_counter;
+    typename storagePolicy::template State<keyType> storage; // compaction pass or destruction mode, see the storage
 
     // ----------- TREE PRIVATE FUNCTIONS -----------
+    static void freeNode(Node *node) {
+        if constexpr (storagePolicy::arena)
+            storagePolicy::freeNode(node);
+        else
+            delete node;
+    }
+
+    // frees every node, on the BackgroundReclaimer thread in background destruction mode
+    void clearNodes() {
+        if constexpr (storagePolicy::background) {
+            if (storage.background_destruction && root != nullptr) {
+                Node *old_root = root;
+                storagePolicy::retire([old_root]() { deleteNodes(old_root); });
+                avl_nodes_counter = 0;
+                root = nullptr;
+                return;
+            }
+        }
+        deleteTree(root);
+        root = nullptr;
+    }
+
     void deleteTree(Node *node) {
         if (node == nullptr)
             return;
         deleteTree(node->right_son);
         deleteTree(node->left_son);
-        delete node;
+        freeNode(node);
         avl_nodes_counter--;
     }
 
-    Node *insertNode(Node *current, Node *const new_node, double current_collector) {
+    Node *insertNode(Node *current, Node *const new_node, rankType current_collector) {
         Node *new_sub_root_after_rotate;
         // stop conditions
         if (current == nullptr)
@@ -104,7 +290,8 @@ private:
                 current->left_son = new_node;
                 new_node->collector -= current_collector + current->collector;
             }
-            current->updateHeight();
+            current->updateSize();
+            current->updateMaxRank();
         }
         else if (new_node->key > current->key) {
             new_sub_root_after_rotate = insertNode(current->right_son, new_node,
@@ -117,39 +304,33 @@ private:
                 current->right_son = new_node;
                 new_node->collector -= current_collector + current->collector;
             }
-            current->updateHeight();
-        }
-        current->updateBalance();
-        if (abs(current->balance) > 1) {
-            try {
-                new_sub_root_after_rotate = rotate(current);
-            }
-            catch (const std::exception &e) {
-                std::cerr << e.what() << std::endl;
-            }
-            assert(current->balance <= 1 && current->balance >= -1);
-            return new_sub_root_after_rotate;
+            current->updateSize();
+            current->updateMaxRank();
         }
-        return nullptr;
+        return fixAfterInsert(current);
     }
 
     static Node *rotate(Node *sub_root) {
         Node *new_sub_root;
         if (sub_root->balance == 2 && sub_root->left_son->balance >= 0) { // LL ROTATE
+            AVL_STATS_ADD(STATS_LL_ROTATIONS, 1);
             new_sub_root = LLrotate(sub_root);
             return new_sub_root;
         }
         else if (sub_root->balance == -2 && sub_root->right_son->balance <= 0) { // RR ROTATE
+            AVL_STATS_ADD(STATS_RR_ROTATIONS, 1);
             new_sub_root = RRrotate(sub_root);
             return new_sub_root;
         }
         else if (sub_root->balance == 2 && sub_root->left_son->balance == -1) { // LR ROTATE
+            AVL_STATS_ADD(STATS_LR_ROTATIONS, 1);
             Node *ll_sub_root = RRrotate(sub_root->left_son);
             sub_root->left_son = ll_sub_root;
             new_sub_root = LLrotate(sub_root);
             return new_sub_root;
         }
         else if (sub_root->balance == -2 && sub_root->right_son->balance == 1) { //RL ROTATE
+            AVL_STATS_ADD(STATS_RL_ROTATIONS, 1);
             Node *rr_sub_root = LLrotate(sub_root->right_son);
             sub_root->right_son = rr_sub_root;
             new_sub_root = RRrotate(sub_root);
@@ -170,6 +351,7 @@ private:
             if (right_grandson != nullptr)
                 right_grandson->updateCollector(son->collector);
             son->updateRank(son->collector);
+            son->addMaxRank(son->collector);
             son->resetCollector();
         }
     }
@@ -181,12 +363,17 @@ private:
         updateRanksBeforeRotate(father, father->left_son);
         updateRanksBeforeRotate(father, father->right_son);
         father->updateRank(father->collector);
+        father->addMaxRank(father->collector);
         father->resetCollector();
 
         father->left_son = old_left_son->right_son;
         old_left_son->right_son = father;
         father->updateHeight();
+        father->updateSize();
+        father->updateMaxRank();
         old_left_son->updateHeight();
+        old_left_son->updateSize();
+        old_left_son->updateMaxRank();
         father->updateBalance();
         old_left_son->updateBalance();
         return old_left_son;
@@ -199,28 +386,52 @@ private:
         updateRanksBeforeRotate(father, father->left_son);
         updateRanksBeforeRotate(father, father->right_son);
         father->updateRank(father->collector);
+        father->addMaxRank(father->collector);
         father->resetCollector();
 
         father->right_son = old_right_son->left_son;
         old_right_son->left_son = father;
         father->updateHeight();
+        father->updateSize();
+        father->updateMaxRank();
         old_right_son->updateHeight();
+        old_right_son->updateSize();
+        old_right_son->updateMaxRank();
         father->updateBalance();
         old_right_son->updateBalance();
         return old_right_son;
     }
 
+    // the key must be in the tree
+    void removeExisting(const int key) {
+        if (root != nullptr && root->key == key && root->right_son == nullptr && root->left_son == nullptr) {
+            Node *node_to_delete = root;
+            root = nullptr;
+            freeNode(node_to_delete);
+            avl_nodes_counter--;
+        }
+        else {
+            Node *new_root_after_rotate = removeNode(root, key);
+            if (new_root_after_rotate != nullptr) {
+                root = new_root_after_rotate;
+            }
+        }
+    }
+
     Node *removeNode(Node *current, const int key) {
         Node *new_sub_root_after_rotate;
         // stop conditions
         if (current == nullptr)
             return nullptr;
 
+        // every node on the path gives its collector to its sons, so nodes can be unlinked without losing ranks
+        current->pushCollector();
+
         // recursion move
         if (key < current->key) {
             new_sub_root_after_rotate = removeNode(current->left_son, key);
             if (new_sub_root_after_rotate != nullptr && new_sub_root_after_rotate->key == key) {
-                delete new_sub_root_after_rotate;
+                freeNode(new_sub_root_after_rotate);
                 avl_nodes_counter--;
                 new_sub_root_after_rotate = nullptr;
                 current->left_son = nullptr;
@@ -233,7 +444,7 @@ private:
         else if (key > current->key) {
             new_sub_root_after_rotate = removeNode(current->right_son, key);
             if (new_sub_root_after_rotate != nullptr && new_sub_root_after_rotate->key == key) {
-                delete new_sub_root_after_rotate;
+                freeNode(new_sub_root_after_rotate);
                 avl_nodes_counter--;
                 new_sub_root_after_rotate = nullptr;
                 current->right_son = nullptr;
@@ -247,7 +458,7 @@ private:
             if (current->left_son == nullptr && current->right_son == nullptr) { // node has no children
                 Node *node_pointer_to_be_deleted = new Node(key, dataType{});
                 avl_nodes_counter++;
-                delete current;
+                freeNode(current);
                 avl_nodes_counter--;
                 return node_pointer_to_be_deleted;
 
@@ -255,137 +466,566 @@ private:
             else if (current->left_son == nullptr) { // node has only right child
 
                 Node *right_son = current->right_son;
-                delete current;
+                freeNode(current);
                 avl_nodes_counter--;
                 return right_son;
             }
             else if (current->right_son == nullptr) { // node has only left child
 
                 Node *left_son = current->left_son;
-                delete current;
+                freeNode(current);
                 avl_nodes_counter--;
                 return left_son;
             }
             else {
 
                 // node has two children:
-                // 1. take the leftmost node of the right child (named "successor").
-                // 2. copy successor in place of the old right child.
-                // 3. make recursion with root: "successor" and key: "successor_key" to delete the leaf copied from.
-                // 4. the return of the recursion will update the whole race heights and balances.
+                // 1. detach the leftmost node of the right child (named "successor"), the collectors on the way
+                //    are pushed down, so its rank is already resolved.
+                // 2. relink the successor in place of the node instead of copying its key and data into it,
+                //    so nodes never change their key and pointers to the other nodes stay valid.
+                // 3. the sub tree root changed, so it is returned even without a rotate.
 
                 // section "1":
-                Node *successor = current->right_son;
-                while (successor->left_son != nullptr) {
-                    successor = successor->left_son;
-                }
+                Node *successor;
+                Node *right_rest = removeMinNode(current->right_son, successor);
 
                 // section "2":
-                current->key = successor->key;
-                current->data = successor->data;
+                successor->left_son = current->left_son;
+                successor->right_son = right_rest;
+                successor->height = current->height;
+                freeNode(current);
+                avl_nodes_counter--;
 
                 // section "3":
-                int successor_key = successor->key;
-                new_sub_root_after_rotate = removeNode(current->right_son, successor->key);
-
-                // section "4":
-                if (new_sub_root_after_rotate != nullptr && new_sub_root_after_rotate->key == successor_key) {
-                    delete new_sub_root_after_rotate;
-                    avl_nodes_counter--;
-                    current->right_son = nullptr;
-                    new_sub_root_after_rotate = nullptr;
-                }
-                if (new_sub_root_after_rotate != nullptr) {
-                    current->right_son = new_sub_root_after_rotate;
-                }
+                successor->updateSize();
+                successor->updateMaxRank();
+                new_sub_root_after_rotate = fixAfterRemove(successor);
+                return new_sub_root_after_rotate == nullptr ? successor : new_sub_root_after_rotate;
             }
         }
-        current->updateHeight();
-        current->updateBalance();
-        if (abs(current->balance) > 1) {
+        current->updateSize();
+        current->updateMaxRank();
+        return fixAfterRemove(current);
+    }
+
+    // ---------------- BALANCE POLICY ----------------
+    // fixAfterInsert / fixAfterRemove - restore the balance of "node" after one of its sub trees grew / shrank.
+    // the size and the max rank of "node" are already updated. Return the new sub root on a rotate, else nullptr.
+    static Node *fixAfterInsert(Node *node) {
+        if (balancePolicy::weak)
+            return weakFixAfterInsert(node);
+        return avlFix(node);
+    }
+
+    static Node *fixAfterRemove(Node *node) {
+        if (balancePolicy::weak)
+            return weakFixAfterRemove(node);
+        return avlFix(node);
+    }
+
+    static Node *avlFix(Node *node) {
+        Node *new_sub_root_after_rotate = nullptr;
+        node->updateHeight();
+        node->updateBalance();
+        if (abs(node->balance) > 1) {
             try {
-                new_sub_root_after_rotate = rotate(current);
+                new_sub_root_after_rotate = rotate(node);
             }
             catch (const std::exception &e) {
                 std::cerr << e.what() << std::endl;
             }
-            assert(abs(current->balance) <= 1);
-            return new_sub_root_after_rotate;
+            assert(abs(node->balance) <= 1);
+        }
+        return new_sub_root_after_rotate;
+    }
+
+    // weak AVL rank difference of a son, a missing son has rank -1
+    static int rankDifference(const Node *node, const Node *son) {
+        return node->height - getHeight(son);
+    }
+
+    // a son rank difference became 0: promote "node" if its other son is at difference 1, else rotate.
+    // the rotations keep the ranks of the other nodes, so they end the fix (LLrotate / RRrotate set the
+    // heights of the nodes they move, the ranks are written after them).
+    static Node *weakFixAfterInsert(Node *node) {
+        int left_difference = rankDifference(node, node->left_son);
+        int right_difference = rankDifference(node, node->right_son);
+        if (left_difference != 0 && right_difference != 0)
+            return nullptr;
+        int node_rank = node->height;
+        if (left_difference + right_difference == 1) { // 0,1 - promote, the father checks its own differences
+            node->height++;
+            return nullptr;
+        }
+        if (left_difference == 0) { // 0,2
+            Node *son = node->left_son;
+            if (rankDifference(son, son->left_son) == 1) { // LL ROTATE
+                AVL_STATS_ADD(STATS_LL_ROTATIONS, 1);
+                Node *new_sub_root = LLrotate(node);
+                son->height = node_rank;
+                node->height = node_rank - 1;
+                return new_sub_root;
+            }
+            AVL_STATS_ADD(STATS_LR_ROTATIONS, 1); // LR ROTATE
+            Node *grandson = son->right_son;
+            node->left_son = RRrotate(son);
+            Node *new_sub_root = LLrotate(node);
+            grandson->height = node_rank;
+            son->height = node_rank - 1;
+            node->height = node_rank - 1;
+            return new_sub_root;
+        }
+        Node *son = node->right_son; // 2,0
+        if (rankDifference(son, son->right_son) == 1) { // RR ROTATE
+            AVL_STATS_ADD(STATS_RR_ROTATIONS, 1);
+            Node *new_sub_root = RRrotate(node);
+            son->height = node_rank;
+            node->height = node_rank - 1;
+            return new_sub_root;
+        }
+        AVL_STATS_ADD(STATS_RL_ROTATIONS, 1); // RL ROTATE
+        Node *grandson = son->left_son;
+        node->right_son = LLrotate(son);
+        Node *new_sub_root = RRrotate(node);
+        grandson->height = node_rank;
+        son->height = node_rank - 1;
+        node->height = node_rank - 1;
+        return new_sub_root;
+    }
+
+    // a leaf must have rank 0, and a son rank difference may have reached 3: demote "node" (and its sibling
+    // son if that one is 2,2) when it keeps the rules, else rotate once or twice, which ends the fix.
+    static Node *weakFixAfterRemove(Node *node) {
+        if (node->left_son == nullptr && node->right_son == nullptr) {
+            node->height = 0;
+            return nullptr;
+        }
+        int left_difference = rankDifference(node, node->left_son);
+        int right_difference = rankDifference(node, node->right_son);
+        if (left_difference != 3 && right_difference != 3)
+            return nullptr;
+        int node_rank = node->height;
+        if (left_difference == 3) {
+            Node *sibling = node->right_son;
+            int inner_difference = rankDifference(sibling, sibling->left_son);
+            int outer_difference = rankDifference(sibling, sibling->right_son);
+            if (right_difference == 2 || (inner_difference == 2 && outer_difference == 2)) {
+                node->height--;
+                if (right_difference == 1)
+                    sibling->height--;
+                return nullptr;
+            }
+            int sibling_rank = sibling->height;
+            if (outer_difference == 1) { // RR ROTATE
+                AVL_STATS_ADD(STATS_RR_ROTATIONS, 1);
+                Node *new_sub_root = RRrotate(node);
+                sibling->height = sibling_rank + 1;
+                node->height = node->left_son == nullptr && node->right_son == nullptr ? 0 : node_rank - 1;
+                return new_sub_root;
+            }
+            AVL_STATS_ADD(STATS_RL_ROTATIONS, 1); // RL ROTATE
+            Node *grandson = sibling->left_son;
+            int grandson_rank = grandson->height;
+            node->right_son = LLrotate(sibling);
+            Node *new_sub_root = RRrotate(node);
+            grandson->height = grandson_rank + 2;
+            sibling->height = sibling_rank - 1;
+            node->height = node_rank - 2;
+            return new_sub_root;
+        }
+        Node *sibling = node->left_son;
+        int inner_difference = rankDifference(sibling, sibling->right_son);
+        int outer_difference = rankDifference(sibling, sibling->left_son);
+        if (left_difference == 2 || (inner_difference == 2 && outer_difference == 2)) {
+            node->height--;
+            if (left_difference == 1)
+                sibling->height--;
+            return nullptr;
         }
-        return nullptr;
+        int sibling_rank = sibling->height;
+        if (outer_difference == 1) { // LL ROTATE
+            AVL_STATS_ADD(STATS_LL_ROTATIONS, 1);
+            Node *new_sub_root = LLrotate(node);
+            sibling->height = sibling_rank + 1;
+            node->height = node->left_son == nullptr && node->right_son == nullptr ? 0 : node_rank - 1;
+            return new_sub_root;
+        }
+        AVL_STATS_ADD(STATS_LR_ROTATIONS, 1); // LR ROTATE
+        Node *grandson = sibling->right_son;
+        int grandson_rank = grandson->height;
+        node->left_son = RRrotate(sibling);
+        Node *new_sub_root = LLrotate(node);
+        grandson->height = grandson_rank + 2;
+        sibling->height = sibling_rank - 1;
+        node->height = node_rank - 2;
+        return new_sub_root;
     }
 
     Node *find(Node *node, const keyType key) const {
-        if (node == nullptr || node->key == key)
-            return node;
+        int visited = 0;
+        while (node != nullptr && node->key != key) {
+            visited++;
+            if (key < node->key)
+                node = node->left_son;
+            else
+                node = node->right_son;
+        }
+        AVL_STATS_ADD(STATS_LOOKUPS, 1);
+        AVL_STATS_ADD(STATS_LOOKUP_NODES_VISITED, visited + (node != nullptr));
+        return node;
+    }
+
+    void exportInorder(const Node *node, keyType *keys, dataType *data, rankType *ranks, int &index,
+                       rankType current_collector) const {
+        if (node == nullptr)
+            return;
+        current_collector += node->collector;
+        exportInorder(node->left_son, keys, data, ranks, index, current_collector);
+        keys[index] = node->key;
+        data[index] = node->data;
+        if (ranks != nullptr)
+            ranks[index] = node->rank + current_collector;
+        index++;
+        exportInorder(node->right_son, keys, data, ranks, index, current_collector);
+    }
 
-        Node *leftResult = find(node->left_son, key);
-        if (leftResult != nullptr)
-            return leftResult;
-        Node *rightResult = find(node->right_son, key);
-        if (rightResult != nullptr)
-            return rightResult;
+    Node *buildFromSorted(const keyType *keys, const dataType *data, const rankType *ranks, int first, int last) {
+        // builds a perfectly balanced sub tree from the sorted range [first, last)
+        if (first >= last)
+            return nullptr;
+        int middle = first + (last - first) / 2;
+        Node *node = new Node(keys[middle], data[middle]);
+        avl_nodes_counter++;
+        if (ranks != nullptr)
+            node->rank = ranks[middle];
+        node->left_son = buildFromSorted(keys, data, ranks, first, middle);
+        node->right_son = buildFromSorted(keys, data, ranks, middle + 1, last);
+        node->updateHeight();
+        node->updateSize();
+        node->updateMaxRank();
+        node->updateBalance();
+        return node;
+    }
 
-        return nullptr;
+    // builds a perfectly balanced sub tree of "size" nodes in key order, taking its entries from "next"
+    template<class sourceFunction>
+    Node *buildInorder(int size, sourceFunction &next) {
+        if (size <= 0)
+            return nullptr;
+        Node *left_son = buildInorder(size / 2, next);
+        keyType key;
+        dataType data;
+        next(key, data);
+        Node *node = new Node(key, data);
+        avl_nodes_counter++;
+        node->left_son = left_son;
+        node->right_son = buildInorder(size - size / 2 - 1, next);
+        node->updateHeight();
+        node->updateSize();
+        node->updateMaxRank();
+        node->updateBalance();
+        return node;
     }
 
-    void updateLeftBranchCollectors(int key_1, Node *node, double amount, bool moved_right) {
+    // adds "amount" to the rank of every node with key < "bound".
+    // walking down, "added" tells if the current sub tree already got "amount" from a collector above it,
+    // the max ranks of the path are fixed on the way back up.
+    static void updateCollectorsBelow(Node *node, int bound, rankType amount, bool added) {
         if (node == nullptr)
             return;
+        if (node->key < bound) {
+            if (!added)
+                node->updateCollector(amount);
+            updateCollectorsBelow(node->right_son, bound, amount, true);
+        }
+        else {
+            if (added)
+                node->updateCollector(-amount);
+            updateCollectorsBelow(node->left_son, bound, amount, false);
+        }
+        node->updateMaxRank();
+    }
 
-        if (key_1 <= node->key) {
-            if (moved_right) {
-                node->collector += amount;
-                moved_right = false;
-            }
-            updateLeftBranchCollectors(key_1, node->left_son, amount, moved_right);
+    static int getHeight(const Node *node) {
+        return node == nullptr ? -1 : node->height;
+    }
+
+    static int getSize(const Node *node) {
+        return node == nullptr ? 0 : node->size;
+    }
+
+    static Node *rebalance(Node *node) {
+        node->updateHeight();
+        node->updateSize();
+        node->updateMaxRank();
+        node->updateBalance();
+        if (abs(node->balance) > 1)
+            return rotate(node);
+        return node;
+    }
+
+    // joins "left" < "middle" < "right" into one AVL tree in O(|height(left) - height(right)|).
+    // "middle" is a detached node without collector, "left" and "right" keep their root collectors.
+    static Node *joinWithNode(Node *left, Node *middle, Node *right) {
+        if (getHeight(left) > getHeight(right) + 1) {
+            left->pushCollector();
+            left->right_son = joinWithNode(left->right_son, middle, right);
+            return rebalance(left);
+        }
+        if (getHeight(right) > getHeight(left) + 1) {
+            right->pushCollector();
+            right->left_son = joinWithNode(left, middle, right->left_son);
+            return rebalance(right);
+        }
+        middle->left_son = left;
+        middle->right_son = right;
+        middle->updateHeight();
+        middle->updateSize();
+        middle->updateMaxRank();
+        middle->updateBalance();
+        return middle;
+    }
+
+    // cuts "node" into the keys smaller than "key" and the keys bigger or equal to "key", O(log n)
+    static void splitNode(Node *node, const keyType key, Node *&smaller, Node *&bigger) {
+        if (node == nullptr) {
+            smaller = nullptr;
+            bigger = nullptr;
+            return;
+        }
+        node->pushCollector();
+        Node *left = node->left_son;
+        Node *right = node->right_son;
+        node->left_son = nullptr;
+        node->right_son = nullptr;
+        if (node->key < key) {
+            Node *right_smaller;
+            splitNode(right, key, right_smaller, bigger);
+            smaller = joinWithNode(left, node, right_smaller);
+        }
+        else {
+            Node *left_bigger;
+            splitNode(left, key, smaller, left_bigger);
+            bigger = joinWithNode(left_bigger, node, right);
+        }
+    }
+
+    // detaches the minimum of "node" into "min_node" (collector already resolved) and returns the new sub root
+    static Node *removeMinNode(Node *node, Node *&min_node) {
+        node->pushCollector();
+        if (node->left_son == nullptr) {
+            min_node = node;
+            Node *right = node->right_son;
+            node->right_son = nullptr;
+            node->updateHeight();
+            node->updateSize();
+            node->updateMaxRank();
+            node->updateBalance();
+            return right;
         }
+        node->left_son = removeMinNode(node->left_son, min_node);
+        node->updateSize();
+        node->updateMaxRank();
+        Node *new_sub_root = fixAfterRemove(node);
+        return new_sub_root == nullptr ? node : new_sub_root;
+    }
 
-        if (key_1 > node->key) {
-            node->collector -= amount;
-            moved_right = true;
-            updateLeftBranchCollectors(key_1, node->right_son, amount, moved_right);
+    // like splitNode, but a node whose key equals "key" is detached into "found" instead of going to "bigger"
+    static void splitNodeExact(Node *node, const keyType key, Node *&smaller, Node *&found, Node *&bigger) {
+        if (node == nullptr) {
+            smaller = nullptr;
+            found = nullptr;
+            bigger = nullptr;
+            return;
+        }
+        node->pushCollector();
+        Node *left = node->left_son;
+        Node *right = node->right_son;
+        node->left_son = nullptr;
+        node->right_son = nullptr;
+        if (node->key == key) {
+            node->updateHeight();
+            node->updateSize();
+            node->updateMaxRank();
+            node->updateBalance();
+            smaller = left;
+            found = node;
+            bigger = right;
+        }
+        else if (node->key < key) {
+            Node *right_smaller;
+            splitNodeExact(right, key, right_smaller, found, bigger);
+            smaller = joinWithNode(left, node, right_smaller);
         }
+        else {
+            Node *left_bigger;
+            splitNodeExact(left, key, smaller, found, left_bigger);
+            bigger = joinWithNode(left_bigger, node, right);
+        }
+    }
+
+    // joins "left" < "right" without a middle node
+    static Node *joinNodes(Node *left, Node *right) {
+        if (right == nullptr)
+            return left;
+        Node *middle;
+        Node *right_rest = removeMinNode(right, middle);
+        return joinWithNode(left, middle, right_rest);
     }
 
-    void updateRightBranchCollectors(int key_2, Node *node, double amount, bool moved_left) {
+    static void deleteNodes(Node *node) {
         if (node == nullptr)
             return;
+        deleteNodes(node->left_son);
+        deleteNodes(node->right_son);
+        freeNode(node);
+    }
+
+    enum SetOperation {
+        SET_UNION,
+        SET_INTERSECTION,
+        SET_DIFFERENCE
+    };
 
-        if (key_2 >= node->key) {
-            if (moved_left) {
-                node->collector += amount;
-                moved_left = false;
+    // join based set operation of two disjoint node sets, consumes both and returns the result root.
+    // the root of "first" splits "second", "halves(first_left, second_left, first_right, second_right, left,
+    // right)" runs the operation on both pairs of halves (independent, see parallelSetOperations.h), then the
+    // results are joined back. Work O(m log(n / m + 1)). On equal keys the node of "first" is kept.
+    template<class halvesFunction>
+    static Node *setOperation(Node *first, Node *second, SetOperation operation, halvesFunction halves) {
+        if (first == nullptr) {
+            if (operation == SET_UNION)
+                return second;
+            deleteNodes(second);
+            return nullptr;
+        }
+        if (second == nullptr) {
+            if (operation == SET_INTERSECTION) {
+                deleteNodes(first);
+                return nullptr;
             }
-            updateRightBranchCollectors(key_2, node->right_son, amount, moved_left);
+            return first;
         }
+        first->pushCollector();
+        Node *first_left = first->left_son;
+        Node *first_right = first->right_son;
+        first->left_son = nullptr;
+        first->right_son = nullptr;
+        Node *second_left, *second_found, *second_right;
+        splitNodeExact(second, first->key, second_left, second_found, second_right);
+
+        Node *left, *right;
+        halves(first_left, second_left, first_right, second_right, left, right);
+
+        bool keep_first = operation == SET_UNION || (operation == SET_INTERSECTION) == (second_found != nullptr);
+        freeNode(second_found);
+        if (keep_first)
+            return joinWithNode(left, first, right);
+        freeNode(first);
+        return joinNodes(left, right);
+    }
+
+    // the whole recursion on the calling thread, depth O(log^2 n)
+    static Node *setOperation(Node *first, Node *second, SetOperation operation) {
+        return setOperation(first, second, operation, [operation](Node *first_left, Node *second_left,
+                                                                  Node *first_right, Node *second_right,
+                                                                  Node *&left, Node *&right) {
+            left = setOperation(first_left, second_left, operation);
+            right = setOperation(first_right, second_right, operation);
+        });
+    }
+
+    // the root becomes "operation_roots(root, other root)" and "other" is emptied
+    template<class operationFunction>
+    void setOperation(Tree &other, operationFunction operation_roots) {
+        static_assert(!balancePolicy::weak, "split / join based operations need the AVL balance policy");
+        root = operation_roots(root, other.root);
+        avl_nodes_counter = getSize(root);
+        other.root = nullptr;
+        other.avl_nodes_counter = 0;
+    }
+
+    void setOperation(Tree &other, SetOperation operation) {
+        setOperation(other, [operation](Node *first, Node *second) {
+            return setOperation(first, second, operation);
+        });
+    }
 
-        if (key_2 < node->key) {
-            node->collector -= amount;
-            moved_left = true;
-            updateLeftBranchCollectors(key_2, node->left_son, amount, moved_left);
+    // topK search entry: a whole sub tree (ranked by its max rank) or its root alone (ranked by its own rank).
+    // "above" is the sum of the collectors above the node, without its own.
+    struct RankEntry {
+        rankType rank;
+        rankType above;
+        const Node *node;
+        bool whole_sub_tree;
+
+        bool operator<(const RankEntry &other) const {
+            return rank < other.rank;
         }
+    };
+
+    static void pushSubTree(std::priority_queue<RankEntry> &queue, const Node *node, rankType above) {
+        if (node != nullptr)
+            queue.push(RankEntry{node->max_rank.value + node->collector + above, above, node, true});
+    }
+
+    static const Node *minNode(const Node *node) {
+        while (node->left_son != nullptr)
+            node = node->left_son;
+        return node;
+    }
+
+    static const Node *maxNode(const Node *node) {
+        while (node->right_son != nullptr)
+            node = node->right_son;
+        return node;
     }
 
 public:
 
     // ----------- TREE PUBLIC FUNCTIONS -----------
-    Tree() : root(nullptr), avl_nodes_counter(0) {}
+    Tree() : root(nullptr), avl_nodes_counter(0), storage() {}
 
     ~Tree() {
-        deleteTree(root);
+        clearNodes();
+    }
+
+    Tree(const Tree &other) = delete;
+
+    Tree &operator=(const Tree &other) = delete;
+
+    Tree(Tree &&other) noexcept: root(other.root), avl_nodes_counter(other.avl_nodes_counter),
+                                 storage(std::move(other.storage)) {
+        other.root = nullptr;
+        other.avl_nodes_counter = 0;
+    }
+
+    Tree &operator=(Tree &&other) noexcept {
+        if (this != &other) {
+            clearNodes();
+            root = other.root;
+            avl_nodes_counter = other.avl_nodes_counter;
+            storage = std::move(other.storage); // the old content went by the old mode
+            other.root = nullptr;
+            other.avl_nodes_counter = 0;
+        }
+        return *this;
     }
 
     Node *find(const keyType key) const {
         return find(root, key);
     }
 
-    void insert(const keyType key, const dataType data) {
-        if (find(root, key) != nullptr) {
-            return;
+    // returns the node of the key, the existing one if the key was already in the tree
+    Node *insert(const keyType key, const dataType data) {
+        Node *existing = find(root, key);
+        if (existing != nullptr) {
+            return existing;
         }
+        Node *new_node = nullptr;
         try {
-            Node *new_node = new Node(key, data);
+            new_node = new Node(key, data);
             avl_nodes_counter++;
             if (root == nullptr)
                 root = new_node;
@@ -399,61 +1039,246 @@ public:
         catch (std::exception &e) {
             std::cerr << e.what() << std::endl;
         }
+        return new_node;
     }
 
-    void upgradeRank(int key_1, int key_2, double amount) {
+    void upgradeRank(int key_1, int key_2, rankType amount) {
         if (key_1 >= key_2)
             return;
-        Node *ancestor = root;
-        bool ancestor_found = false;
-        while (!ancestor_found) {
-            if (ancestor == nullptr)
-                return;
-            if (key_1 < ancestor->key && key_2 < ancestor->key)
-                ancestor = ancestor->left_son;
-            if (key_1 > ancestor->key && key_2 > ancestor->key)
-                ancestor = ancestor->right_son;
-            else
-                ancestor_found = true;
-        }
-        updateLeftBranchCollectors(key_1, ancestor, amount, true);
-        updateRightBranchCollectors(key_2, ancestor, amount, false);
+        updateCollectorsBelow(root, key_2, amount, false);
+        updateCollectorsBelow(root, key_1, -amount, false);
     }
 
     void remove(const int key) {
         if (find(root, key) == nullptr)
             return;
-        if (root != nullptr && root->key == key && root->right_son == nullptr && root->left_son == nullptr) {
-            Node *node_to_delete = root;
-            root = nullptr;
-            delete node_to_delete;
-            avl_nodes_counter--;
-        }
-        else {
-            Node *new_root_after_rotate = removeNode(root, key);
-            if (new_root_after_rotate != nullptr) {
-                root = new_root_after_rotate;
-            }
-        }
+        removeExisting(key);
+    }
+
+    // removes a node of this tree (a handle from insert / find) without looking its key up first, one walk
+    void remove(Node *node) {
+        removeExisting(node->key);
     }
 
     Node *getRoot() const {
         return root;
     }
 
-    double getNodeRank(const Node *node, keyType key, double current_collector = 0) const {
+    // keeps the keys smaller than "key" and returns a tree of the keys bigger or equal to it, O(log n)
+    Tree split(const keyType key) {
+        static_assert(!balancePolicy::weak, "split / join based operations need the AVL balance policy");
+        Tree bigger;
+        Node *smaller_root;
+        splitNode(root, key, smaller_root, bigger.root);
+        root = smaller_root;
+        avl_nodes_counter = getSize(root);
+        bigger.avl_nodes_counter = getSize(bigger.root);
+        return bigger;
+    }
+
+    // appends every node of "right" (all its keys must be bigger than this tree keys) and empties it, O(log n)
+    void join(Tree &right) {
+        static_assert(!balancePolicy::weak, "split / join based operations need the AVL balance policy");
+        if (right.root == nullptr)
+            return;
+        if (root != nullptr && !(maxNode(root)->key < minNode(right.root)->key))
+            throw joinError();
+        Node *middle;
+        Node *right_rest = removeMinNode(right.root, middle);
+        root = joinWithNode(root, middle, right_rest);
+        avl_nodes_counter += right.avl_nodes_counter;
+        right.root = nullptr;
+        right.avl_nodes_counter = 0;
+    }
+
+    // removes every key in [lo, hi): the range is cut out with two splits, freed in one pass without any
+    // rebalancing, and the two sides are joined back - O(log n + k). Returns the number of removed keys.
+    int removeRange(const keyType lo, const keyType hi) {
+        static_assert(!balancePolicy::weak, "split / join based operations need the AVL balance policy");
+        if (!(lo < hi))
+            return 0;
+        Node *smaller, *rest, *range, *bigger;
+        splitNode(root, lo, smaller, rest);
+        splitNode(rest, hi, range, bigger);
+        int removed = getSize(range);
+        deleteNodes(range);
+        root = joinNodes(smaller, bigger);
+        avl_nodes_counter -= removed;
+        return removed;
+    }
+
+    static Tree join(Tree &left, Tree &right) {
+        Tree joined(std::move(left));
+        joined.join(right);
+        return joined;
+    }
+
+    // adds every key of "other" missing from this tree and empties "other".
+    // keys found in both keep this tree's data and rank, like insert of an existing key.
+    void unite(Tree &other) {
+        setOperation(other, SET_UNION);
+    }
+
+    // keeps only the keys that are also in "other" and empties "other"
+    void intersect(Tree &other) {
+        setOperation(other, SET_INTERSECTION);
+    }
+
+    // removes the keys that are in "other" and empties "other"
+    void subtract(Tree &other) {
+        setOperation(other, SET_DIFFERENCE);
+    }
+
+    int getNodeCounter() const {
+        return avl_nodes_counter;
+    }
+
+    // opt-in: old nodes are freed on the BackgroundReclaimer thread (see the READ ME), the mode moves with the tree
+    void setBackgroundDestruction(bool background) {
+        static_assert(storagePolicy::background, "background destruction needs the BackgroundStorage");
+        storage.background_destruction = background;
+    }
+
+    // writes the min(k, getNodeCounter()) entries with the highest effective ranks in descending rank order
+    // (ties in any order) and returns their number, every array must have room for them, "ranks" may be nullptr.
+    // Best first search on the max ranks: every popped sub tree adds its root and its two sons to the queue,
+    // so O(k log k) no matter how big the tree is.
+    int topK(int k, keyType *keys, dataType *data, rankType *ranks) const {
+        static_assert(augmentPolicy::max_rank, "topK needs the MaxRankAugment augmentation");
+        std::priority_queue<RankEntry> queue;
+        pushSubTree(queue, root, rankType());
+        int found = 0;
+        while (found < k && !queue.empty()) {
+            RankEntry entry = queue.top();
+            queue.pop();
+            const Node *node = entry.node;
+            if (!entry.whole_sub_tree) {
+                keys[found] = node->key;
+                data[found] = node->data;
+                if (ranks != nullptr)
+                    ranks[found] = entry.rank;
+                found++;
+                continue;
+            }
+            rankType below = entry.above + node->collector;
+            queue.push(RankEntry{node->rank + below, entry.above, node, false});
+            pushSubTree(queue, node->left_son, below);
+            pushSubTree(queue, node->right_son, below);
+        }
+        return found;
+    }
+
+    static size_t getNodeBytes() {
+        return sizeof(Node);
+    }
+
+    // writes keys, data and effective ranks (collectors already resolved) in ascending key order.
+    // every array must have room for getNodeCounter() elements, "ranks" may be nullptr.
+    void exportInorder(keyType *keys, dataType *data, rankType *ranks) const {
+        int index = 0;
+        exportInorder(root, keys, data, ranks, index, 0);
+    }
+
+    // replaces the tree content with "size" entries given in strictly ascending key order - O(n).
+    // "ranks" may be nullptr, then every rank starts at 0.
+    void buildFromSorted(const keyType *keys, const dataType *data, const rankType *ranks, int size) {
+        clearNodes();
+        root = buildFromSorted(keys, data, ranks, 0, size);
+    }
+
+    // the same build from a stream: "next(key, data)" is called "size" times and gives the entries in strictly
+    // ascending key order, every rank starts at 0. "next" must not throw.
+    template<class sourceFunction>
+    void buildFromSorted(int size, sourceFunction next) {
+        clearNodes();
+        root = buildInorder(size, next);
+    }
+
+    // moves up to "steps" nodes into the compaction blocks, in key order from the key after the last moved one,
+    // relinking their fathers - O(log n + steps). Returns true when the pass moved the biggest key, the next
+    // call starts a new pass from the smallest. Keys inserted behind the cursor wait for the next pass.
+    bool compact(int steps) {
+        static_assert(storagePolicy::arena, "compact needs the ArenaStorage");
+        // path from the root down to the first node to move, every entry is the father of the next one
+        std::vector<Node *> path;
+        int depth = 0;
+        for (Node *node = root; node != nullptr;) {
+            path.push_back(node);
+            if (storage.compact_started && !(storage.compact_cursor < node->key)) {
+                node = node->right_son;
+            }
+            else {
+                depth = (int) path.size();
+                node = node->left_son;
+            }
+        }
+        path.resize(depth);
+        for (; steps > 0 && !path.empty(); steps--) {
+            Node *moved = storagePolicy::moveNode(storage, path.back());
+            AVL_STATS_ADD(STATS_ALLOCATIONS, 1);
+            if (path.size() == 1)
+                root = moved;
+            else if (path[path.size() - 2]->left_son == path.back())
+                path[path.size() - 2]->left_son = moved;
+            else
+                path[path.size() - 2]->right_son = moved;
+            path.back() = moved;
+            storage.compact_cursor = moved->key;
+            storage.compact_started = true;
+
+            // in order successor: the leftmost node of the right son, else the first father reached from the left
+            if (moved->right_son != nullptr) {
+                for (Node *node = moved->right_son; node != nullptr; node = node->left_son)
+                    path.push_back(node);
+            }
+            else {
+                while (path.size() > 1 && path[path.size() - 2]->right_son == path.back())
+                    path.pop_back();
+                path.pop_back();
+            }
+        }
+        if (!path.empty())
+            return false;
+        storage.compact_started = false;
+        return true;
+    }
+
+    rankType getNodeRank(const Node *node, keyType key, rankType current_collector = 0) const {
         if (node == nullptr)
-            return 0.0;
+            return rankType();
         if (node->key == key)
             return node->rank + node->collector + current_collector;
 
         if (key < node->key)
-            getNodeRank(node->left_son, key, node->collector + current_collector);
-        if (key > node->key)
-            getNodeRank(node->right_son, key, node->collector + current_collector);
-        return 0.0;
+            return getNodeRank(node->left_son, key, node->collector + current_collector);
+        return getNodeRank(node->right_son, key, node->collector + current_collector);
+    }
+
+    rankType getNodeRank(keyType key) const {
+        return getNodeRank(root, key);
+    }
+
+    // -------------- STATS FUNCTIONS --------------
+#ifdef AVL_STATS_ON
+
+    int getHeight() const {
+        return root == nullptr ? -1 : root->height;
+    }
+
+    long long getMemoryBytes() const {
+        return (long long) sizeof(*this) + (long long) avl_nodes_counter * (long long) sizeof(Node);
+    }
+
+    // JSON object with the global counters and the size of this tree
+    void dumpStats(std::ostream &stream) const {
+        stream << "{";
+        dumpTreeStatsMembers(stream);
+        stream << ", \"nodes\": " << avl_nodes_counter << ", \"height\": " << getHeight()
+               << ", \"memory_bytes\": " << getMemoryBytes() << "}";
     }
 
+#endif /* AVL_STATS_ON */
+
     // -------------- DEBUG FUNCTIONS --------------
 
 #ifdef DEBUG_ON
@@ -466,10 +1291,6 @@ public:
         printTreeInorder(node->right_son);
     }
 
-    int getNodeCounter() const {
-        return avl_nodes_counter;
-    }
-
     std::vector<dataType> KeysVector() const {
         std::vector<dataType> vec;
         buildKeysVector(root, vec);
@@ -484,6 +1305,41 @@ public:
         buildKeysVector(root_t->right_son, vec);
     }
 
+    // checks keys order, heights, balances, sizes, max ranks and the AVL condition of the whole tree
+    // (with WAVLBalance: the rank differences and the leaf ranks instead of the heights and balances)
+    bool checkInvariants() const {
+        int nodes = 0;
+        return checkInvariants(root, nullptr, nullptr, nodes) != -2 && nodes == avl_nodes_counter;
+    }
+
+    // returns the height (WAVL: the rank) of the sub tree, or -2 if any invariant is broken
+    int checkInvariants(const Node *node, const keyType *low, const keyType *high, int &nodes) const {
+        if (node == nullptr)
+            return -1;
+        nodes++;
+        if ((low != nullptr && !(*low < node->key)) || (high != nullptr && !(node->key < *high)))
+            return -2;
+        int nodes_before = nodes;
+        int left_height = checkInvariants(node->left_son, low, &node->key, nodes);
+        int right_height = checkInvariants(node->right_son, &node->key, high, nodes);
+        if (left_height == -2 || right_height == -2)
+            return -2;
+        if (balancePolicy::weak) {
+            int left_difference = node->height - left_height;
+            int right_difference = node->height - right_height;
+            if (left_difference < 1 || left_difference > 2 || right_difference < 1 || right_difference > 2 ||
+                (left_height == -1 && right_height == -1 && node->height != 0) ||
+                node->size != nodes - nodes_before + 1 || !node->checkMaxRank())
+                return -2;
+            return node->height;
+        }
+        int height = (left_height > right_height ? left_height : right_height) + 1;
+        if (node->height != height || node->balance != left_height - right_height || abs(node->balance) > 1 ||
+            node->size != nodes - nodes_before + 1 || !node->checkMaxRank())
+            return -2;
+        return height;
+    }
+
     void printCollectorsInorder(const Node *node) const {
         if (node == nullptr)
             return;
@@ -492,7 +1348,7 @@ public:
         printCollectorsInorder(node->right_son);
     }
 
-    void printRanksInorder(const Node *node, double current_collector = 0) {
+    void printRanksInorder(const Node *node, rankType current_collector = 0) {
         if (node == nullptr)
             return;
         printRanksInorder(node->left_son, node->collector + current_collector);
@@ -0,0 +1,825 @@
+
+// -------------------- LIBRARIES --------------------
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <memory>
+#include <string>
+
+// -------------------- DEBUG ON! --------------------
+#define DEBUG_ON
+
+// ------------------ INCLUDE FILES ------------------
+#include "../hashTable.h"
+#include "../shardedHashTable.h"
+#include "../indexedRankedTree.h"
+#include "persistentRankedTree.h"
+#include "fixedPoint.h"
+#include "fixedRankedTree.h"
+#include "frozenRankedTree.h"
+#include "parallelSetOperations.h"
+#include "nodeArena.h"
+
+// --------------------- DEFINES ---------------------
+#define DEFAULT_NUMBER_OF_OPERATIONS 1000000
+#define DEFAULT_SEED 234218
+#define CHECK_INTERVAL 100000
+#define MAX_RANK_RANGE 64
+#define MAX_SET_OPERATION_KEYS 20000
+#define PERSISTENT_SNAPSHOTS 4
+#define SHARDED_THREADS 4
+#define FIXED_TREE_CAPACITY 4096
+#define MAX_TOP_K 100
+#define COMPACT_INTERVAL 16
+#define COMPACT_STEPS 32
+
+// --------------------- READ ME ---------------------
+// Randomized differential test of the ranked Tree against std::map (keys, data and ranks)
+// and of the HashTable against std::unordered_map, which is drained at the end to check its shrinking.
+// Trees and tables in background destruction mode hand their old content to the reclaimer thread.
+// A HashTable of owning data (shared strings) grows through several rehashes, shrinks by removes and is destroyed:
+// only the live entries may hold a copy of the data, the use count of the shared string tells.
+// The ShardedHashTable gets concurrent inserts from several threads plus bulk inserts and lookups.
+// upgradeRank amounts are integers, so the double ranks are exact and compared with ==.
+// The ranked tree runs with double, int64_t and FixedPoint ranks.
+// split / join round trips run between the operations and must keep keys, data and ranks,
+// removeRange must remove exactly the keys of its range.
+// The extended checks run in separate, untimed runs, so the reported ops/s measure the tree operations only:
+// compact runs every COMPACT_INTERVAL operations, and every check finishes a whole pass and checks that the nodes
+// are laid out in key order. Every check also runs unite / intersect / subtract with a random tree on up to 4
+// threads, freezes the tree and compares topK (the first MAX_TOP_K and all the entries) with the sorted reference
+// ranks.
+// Every tree type runs the same differential loop (stressTree) through an adapter of its API and checks.
+// The PersistentTree runs the same operations and keeps old snapshots, which must never change.
+// A WAVLBalance tree runs a remove heavy mix of them, its rank rules and height bound are checked as well.
+// The IndexedTree runs them too, and the data pointer found for a key must not change while the key lives.
+// The FixedTree runs them on a key space that fits its capacity, and is built at compile time once.
+// The AVL invariants and the whole content are checked every CHECK_INTERVAL operations and at the end.
+// Usage: ranked_stress_test [number_of_operations] [seed]
+
+struct ReferenceEntry {
+    int data;
+    double rank;
+};
+
+typedef std::map<int, ReferenceEntry> ReferenceTree;
+typedef FixedPoint<16> FixedRank;
+
+// the ranked tree under test, with the max ranks that topK needs and the arena nodes that compact needs
+template<class rankType>
+using RankedTree = Tree<int, int, rankType, AVLBalance, MaxRankAugment, ArenaStorage>;
+
+typedef Tree<int, int, double, AVLBalance, NoRankAugment, BackgroundStorage> BackgroundTree;
+
+double rankValue(double rank) {
+    return rank;
+}
+
+double rankValue(int64_t rank) {
+    return (double) rank;
+}
+
+double rankValue(FixedRank rank) {
+    return rank.toDouble();
+}
+
+template<class treeType>
+bool sameContent(const treeType &tree, const ReferenceTree &reference) {
+    int size = tree.getNodeCounter();
+    if (size != (int) reference.size())
+        return false;
+    std::vector<int> keys(size), data(size);
+    std::vector<decltype(tree.getNodeRank(0))> ranks(size);
+    tree.exportInorder(keys.data(), data.data(), ranks.data());
+    int i = 0;
+    for (const auto &entry: reference) {
+        if (keys[i] != entry.first || data[i] != entry.second.data || rankValue(ranks[i]) != entry.second.rank)
+            return false;
+        i++;
+    }
+    return true;
+}
+
+template<class rankType>
+RankedTree<rankType> copyTree(const RankedTree<rankType> &tree) {
+    int size = tree.getNodeCounter();
+    std::vector<int> keys(size), data(size);
+    std::vector<rankType> ranks(size);
+    tree.exportInorder(keys.data(), data.data(), ranks.data());
+    RankedTree<rankType> copy;
+    copy.buildFromSorted(keys.data(), data.data(), ranks.data(), size);
+    return copy;
+}
+
+// runs unite, intersect and subtract of "tree" with a random tree, on several threads, against std::map
+template<class rankType>
+bool checkSetOperations(const RankedTree<rankType> &tree, const ReferenceTree &reference, std::mt19937 &generator,
+                        int key_space) {
+    std::uniform_int_distribution<int> keys(0, key_space);
+    std::vector<int> other_keys;
+    for (size_t i = 0; i < std::min(reference.size() / 2 + 1, (size_t) MAX_SET_OPERATION_KEYS); i++)
+        other_keys.push_back(keys(generator));
+    for (int operation = 0; operation < 3; operation++) {
+        RankedTree<rankType> result = copyTree(tree);
+        result.compact(result.getNodeCounter() / 2); // the operations free heap and arena nodes on up to 4 threads
+        RankedTree<rankType> other;
+        ReferenceTree other_reference;
+        for (int key: other_keys) {
+            other.insert(key, -key);
+            other_reference.insert(std::make_pair(key, ReferenceEntry{-key, 0}));
+        }
+        ReferenceTree expected;
+        if (operation == 0) {
+            parallelUnite(result, other, 4);
+            expected = reference;
+            expected.insert(other_reference.begin(), other_reference.end());
+        }
+        else if (operation == 1) {
+            parallelIntersect(result, other, 4);
+            for (const auto &entry: reference) {
+                if (other_reference.count(entry.first) == 1)
+                    expected.insert(entry);
+            }
+        }
+        else {
+            parallelSubtract(result, other, 4);
+            for (const auto &entry: reference) {
+                if (other_reference.count(entry.first) == 0)
+                    expected.insert(entry);
+            }
+        }
+        if (other.getNodeCounter() != 0 || !result.checkInvariants() || !sameContent(result, expected))
+            return false;
+    }
+    return true;
+}
+
+// freezes "tree" and compares find, lowerBound and getNodeRank on random keys with std::map
+template<class rankType>
+bool checkFrozen(const RankedTree<rankType> &tree, const ReferenceTree &reference, std::mt19937 &generator,
+                 int key_space) {
+    FrozenTree<int, int, rankType> frozen = freeze(tree);
+    std::uniform_int_distribution<int> keys(-1, key_space + 1);
+    for (int i = 0; i < CHECK_INTERVAL / 10; i++) {
+        int key = keys(generator);
+        auto expected = reference.lower_bound(key);
+        int slot = frozen.lowerBound(key);
+        if ((slot == 0) != (expected == reference.end()) ||
+            (slot != 0 && (frozen.getKey(slot) != expected->first || frozen.getData(slot) != expected->second.data ||
+                           rankValue(frozen.getRank(slot)) != expected->second.rank)))
+            return false;
+        bool exists = expected != reference.end() && expected->first == key;
+        if ((frozen.find(key) != nullptr) != exists ||
+            (exists && rankValue(frozen.getNodeRank(key)) != expected->second.rank))
+            return false;
+    }
+    return frozen.getNodeCounter() == (int) reference.size();
+}
+
+// topK returns the highest ranks of std::map in descending order, each with the key, data and rank of its entry
+template<class treeType>
+bool checkTopK(const treeType &tree, const ReferenceTree &reference, int k) {
+    std::vector<double> expected_ranks;
+    for (const auto &entry: reference)
+        expected_ranks.push_back(entry.second.rank);
+    std::sort(expected_ranks.begin(), expected_ranks.end(), std::greater<double>());
+    std::vector<int> keys(k), data(k);
+    std::vector<decltype(tree.getNodeRank(0))> ranks(k);
+    int found = tree.topK(k, keys.data(), data.data(), ranks.data());
+    if (found != std::min(k, (int) reference.size()))
+        return false;
+    for (int i = 0; i < found; i++) {
+        auto entry = reference.find(keys[i]);
+        if (rankValue(ranks[i]) != expected_ranks[i] || entry == reference.end() ||
+            entry->second.data != data[i] || entry->second.rank != expected_ranks[i])
+            return false;
+    }
+    return true;
+}
+
+// finishes the running compaction pass and a whole new one, then the nodes of consecutive keys must be
+// consecutive in memory, except between two arena blocks
+template<class treeType>
+bool checkCompacted(treeType &tree, const ReferenceTree &reference) {
+    while (!tree.compact(COMPACT_STEPS)) {}
+    while (!tree.compact(COMPACT_STEPS)) {}
+    int breaks = 0;
+    const char *previous = nullptr;
+    for (const auto &entry: reference) {
+        const char *node = (const char *) tree.find(entry.first);
+        if (previous != nullptr && node - previous != (long) sizeof(*tree.find(entry.first)))
+            breaks++;
+        previous = node;
+    }
+    return breaks <= (int) reference.size() / ArenaBlock::slotsNumber(sizeof(*tree.getRoot())) + 1;
+}
+
+// every key of "smaller" is below "key" and every key of "bigger" is at least "key"
+template<class rankType>
+bool splitAt(const RankedTree<rankType> &smaller, const RankedTree<rankType> &bigger, int key) {
+    auto max_node = smaller.getRoot();
+    while (max_node != nullptr && max_node->right_son != nullptr)
+        max_node = max_node->right_son;
+    auto min_node = bigger.getRoot();
+    while (min_node != nullptr && min_node->left_son != nullptr)
+        min_node = min_node->left_son;
+    return (max_node == nullptr || max_node->key < key) && (min_node == nullptr || min_node->key >= key);
+}
+
+// --------------------- STRESS DRIVER ---------------------
+enum StressOperation {
+    STRESS_INSERT,
+    STRESS_REMOVE,
+    STRESS_UPGRADE_RANK,
+    STRESS_FIND,
+    STRESS_REMOVE_RANGE,
+    STRESS_SPLIT_JOIN,
+    STRESS_OPERATIONS_NUMBER
+};
+
+// stressTree runs the same differential loop on every ranked tree type through an adapter, which gives: name,
+// key_space (keys are drawn from [0, key_space]), mix (the weight of every StressOperation), insert, remove,
+// upgradeRank, findData (nullptr if the key does not exist), getNodeRank (as a double), check (invariants and
+// content against the reference, returns the name of the failed check or nullptr) and the StressAdapter hooks.
+struct StressAdapter {
+    // checks a found key beyond its data and rank
+    bool checkFound(int /*key*/, const int * /*data*/) {
+        return true;
+    }
+
+    void operationDone(long long /*operation*/, const ReferenceTree & /*reference*/) {}
+
+    // called only by adapters whose mix has STRESS_REMOVE_RANGE / STRESS_SPLIT_JOIN
+    int removeRange(int /*key_1*/, int /*key_2*/) {
+        return 0;
+    }
+
+    bool splitJoin(int /*key*/, int /*size*/) {
+        return true;
+    }
+};
+
+bool stressFailed(const char *name, const std::string &check, long long operation) {
+    std::cout << "fail (" << name << " " << check << " at operation " << operation << ")" << std::endl;
+    return false;
+}
+
+template<class adapterType>
+bool stressTree(adapterType &tree, long long operations, unsigned int seed) {
+    std::vector<StressOperation> mix;
+    for (int operation = 0; operation < STRESS_OPERATIONS_NUMBER; operation++)
+        mix.insert(mix.end(), tree.mix[operation], (StressOperation) operation);
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> keys(0, tree.key_space);
+    std::uniform_int_distribution<int> types(0, (int) mix.size() - 1);
+    std::uniform_int_distribution<int> ranges(0, MAX_RANK_RANGE);
+    std::uniform_int_distribution<int> amounts(-5, 5);
+    ReferenceTree reference;
+
+    for (long long i = 1; i <= operations; i++) {
+        int key = keys(generator);
+        StressOperation operation = mix[types(generator)];
+        if (operation == STRESS_INSERT) {
+            tree.insert(key, (int) i);
+            reference.insert(std::make_pair(key, ReferenceEntry{(int) i, 0}));
+        }
+        else if (operation == STRESS_REMOVE) {
+            tree.remove(key);
+            reference.erase(key);
+        }
+        else if (operation == STRESS_UPGRADE_RANK) {
+            int key_2 = key + ranges(generator);
+            int amount = amounts(generator);
+            tree.upgradeRank(key, key_2, amount);
+            for (auto it = reference.lower_bound(key); it != reference.end() && it->first < key_2; ++it)
+                it->second.rank += amount;
+        }
+        else if (operation == STRESS_REMOVE_RANGE) {
+            int key_2 = key + ranges(generator);
+            int removed = tree.removeRange(key, key_2);
+            int expected = 0;
+            for (auto it = reference.lower_bound(key); it != reference.end() && it->first < key_2; expected++)
+                it = reference.erase(it);
+            if (removed != expected)
+                return stressFailed(tree.name, "removeRange " + std::to_string(key), i);
+        }
+        else if (operation == STRESS_SPLIT_JOIN) {
+            if (!tree.splitJoin(key, (int) reference.size()))
+                return stressFailed(tree.name, "split " + std::to_string(key), i);
+        }
+        else {
+            auto expected = reference.find(key);
+            const int *found = tree.findData(key);
+            if ((found == nullptr) != (expected == reference.end()) ||
+                (found != nullptr && (*found != expected->second.data ||
+                                      tree.getNodeRank(key) != expected->second.rank || !tree.checkFound(key, found))))
+                return stressFailed(tree.name, "find " + std::to_string(key), i);
+        }
+        tree.operationDone(i, reference);
+        if (i % CHECK_INTERVAL == 0 || i == operations) {
+            const char *failed = tree.check(reference);
+            if (failed != nullptr)
+                return stressFailed(tree.name, failed, i);
+        }
+    }
+    return true;
+}
+
+// --------------------- STRESS ADAPTERS ---------------------
+template<class rankType>
+struct RankedTreeAdapter : StressAdapter {
+    const char *name = "ranked tree";
+    int key_space;
+    int mix[STRESS_OPERATIONS_NUMBER] = {8, 4, 4, 2, 1, 1};
+    bool extended_checks;
+    std::mt19937 generator; // random trees and keys of the extended checks
+    RankedTree<rankType> tree;
+
+    RankedTreeAdapter(long long operations, unsigned int seed, bool extended_checks) :
+            key_space((int) std::max(16LL, operations / 2)), extended_checks(extended_checks), generator(seed) {}
+
+    void insert(int key, int data) {
+        tree.insert(key, data);
+    }
+
+    void remove(int key) {
+        tree.remove(key);
+    }
+
+    void upgradeRank(int key_1, int key_2, int amount) {
+        tree.upgradeRank(key_1, key_2, amount);
+    }
+
+    const int *findData(int key) {
+        auto node = tree.find(key);
+        return node == nullptr ? nullptr : &node->data;
+    }
+
+    double getNodeRank(int key) {
+        return rankValue(tree.getNodeRank(key));
+    }
+
+    int removeRange(int key_1, int key_2) {
+        return tree.removeRange(key_1, key_2);
+    }
+
+    bool splitJoin(int key, int size) {
+        RankedTree<rankType> bigger = tree.split(key);
+        bool split = splitAt(tree, bigger, key) && tree.getNodeCounter() + bigger.getNodeCounter() == size;
+        tree.join(bigger);
+        return split;
+    }
+
+    void operationDone(long long operation, const ReferenceTree & /*reference*/) {
+        if (extended_checks && operation % COMPACT_INTERVAL == 0)
+            tree.compact(COMPACT_STEPS);
+    }
+
+    const char *check(const ReferenceTree &reference) {
+        if (!tree.checkInvariants() || !sameContent(tree, reference))
+            return "invariants";
+        if (!extended_checks)
+            return nullptr;
+        if (!checkCompacted(tree, reference) || !tree.checkInvariants() || !sameContent(tree, reference))
+            return "compact";
+        if (!checkTopK(tree, reference, MAX_TOP_K) || !checkTopK(tree, reference, (int) reference.size() + 1))
+            return "topK";
+        if (!checkFrozen(tree, reference, generator, key_space))
+            return "freeze";
+        if (!checkSetOperations(tree, reference, generator, key_space))
+            return "set operations";
+        return nullptr;
+    }
+};
+
+// keeps PERSISTENT_SNAPSHOTS old versions, taken every CHECK_INTERVAL / 10 operations, which must never change
+struct PersistentTreeAdapter : StressAdapter {
+    const char *name = "persistent tree";
+    int key_space;
+    int mix[STRESS_OPERATIONS_NUMBER] = {6, 4, 4, 2, 0, 0};
+    PersistentTree<int, int> tree;
+    std::vector<PersistentTree<int, int>> snapshots;
+    std::vector<ReferenceTree> snapshot_references;
+
+    explicit PersistentTreeAdapter(long long operations) : key_space((int) std::max(16LL, operations / 2)),
+                                                           snapshots(PERSISTENT_SNAPSHOTS),
+                                                           snapshot_references(PERSISTENT_SNAPSHOTS) {}
+
+    void insert(int key, int data) {
+        tree.insert(key, data);
+    }
+
+    void remove(int key) {
+        tree.remove(key);
+    }
+
+    void upgradeRank(int key_1, int key_2, int amount) {
+        tree.upgradeRank(key_1, key_2, amount);
+    }
+
+    const int *findData(int key) {
+        return tree.find(key);
+    }
+
+    double getNodeRank(int key) {
+        return tree.getNodeRank(key);
+    }
+
+    void operationDone(long long operation, const ReferenceTree &reference) {
+        if (operation % (CHECK_INTERVAL / 10) == 0) {
+            int slot = (int) (operation / (CHECK_INTERVAL / 10) % PERSISTENT_SNAPSHOTS);
+            snapshots[slot] = tree.snapshot();
+            snapshot_references[slot] = reference;
+        }
+    }
+
+    const char *check(const ReferenceTree &reference) {
+        if (!tree.checkInvariants() || !sameContent(tree, reference))
+            return "invariants";
+        for (int slot = 0; slot < PERSISTENT_SNAPSHOTS; slot++) {
+            if (!snapshots[slot].checkInvariants() || !sameContent(snapshots[slot], snapshot_references[slot]))
+                return "snapshot";
+        }
+        return nullptr;
+    }
+};
+
+constexpr FixedTree<int, int, 8, int64_t> buildConstantTree() {
+    FixedTree<int, int, 8, int64_t> tree;
+    for (int key = 0; key < 8; key++)
+        tree.insert(key, key * key);
+    tree.upgradeRank(2, 6, 3);
+    tree.remove(4);
+    return tree;
+}
+
+constexpr FixedTree<int, int, 8, int64_t> CONSTANT_TREE = buildConstantTree();
+static_assert(CONSTANT_TREE.getNodeCounter() == 7 && CONSTANT_TREE.find(4) == nullptr &&
+              CONSTANT_TREE.find(3)->data == 9 && CONSTANT_TREE.getNodeRank(5) == 3 &&
+              CONSTANT_TREE.getNodeRank(6) == 0 && CONSTANT_TREE.getNodeRank(CONSTANT_TREE.getRoot(), 3) == 3,
+              "constexpr FixedTree");
+
+// a key space that fits the capacity of the tree, which lives on the heap (it is too big for the stack)
+struct FixedTreeAdapter : StressAdapter {
+    const char *name = "fixed tree";
+    int key_space = FIXED_TREE_CAPACITY - 1;
+    int mix[STRESS_OPERATIONS_NUMBER] = {6, 4, 4, 2, 0, 0};
+    std::unique_ptr<FixedTree<int, int, FIXED_TREE_CAPACITY>> tree{new FixedTree<int, int, FIXED_TREE_CAPACITY>};
+
+    void insert(int key, int data) {
+        tree->insert(key, data);
+    }
+
+    void remove(int key) {
+        tree->remove(key);
+    }
+
+    void upgradeRank(int key_1, int key_2, int amount) {
+        tree->upgradeRank(key_1, key_2, amount);
+    }
+
+    const int *findData(int key) {
+        auto node = tree->find(key);
+        return node == nullptr ? nullptr : &node->data;
+    }
+
+    double getNodeRank(int key) {
+        return tree->getNodeRank(tree->getRoot(), key);
+    }
+
+    // inserting a key that exists gives back its node, unchanged
+    bool checkFound(int key, const int *data) {
+        int found_data = *data;
+        auto node = tree->insert(key, found_data + 1);
+        return &node->data == data && node->data == found_data;
+    }
+
+    const char *check(const ReferenceTree &reference) {
+        return tree->checkInvariants() && sameContent(*tree, reference) ? nullptr : "invariants";
+    }
+};
+
+// a remove heavy mix, the WAVL rank rules (checkInvariants) and the 2 log n height bound are checked as well
+struct WeakAvlTreeAdapter : StressAdapter {
+    const char *name = "WAVL tree";
+    int key_space;
+    int mix[STRESS_OPERATIONS_NUMBER] = {7, 6, 2, 1, 0, 0};
+    Tree<int, int, double, WAVLBalance, MaxRankAugment> tree;
+
+    explicit WeakAvlTreeAdapter(long long operations) : key_space((int) std::max(16LL, operations / 2)) {}
+
+    void insert(int key, int data) {
+        tree.insert(key, data);
+    }
+
+    void remove(int key) {
+        tree.remove(key);
+    }
+
+    void upgradeRank(int key_1, int key_2, int amount) {
+        tree.upgradeRank(key_1, key_2, amount);
+    }
+
+    const int *findData(int key) {
+        auto node = tree.find(key);
+        return node == nullptr ? nullptr : &node->data;
+    }
+
+    double getNodeRank(int key) {
+        return tree.getNodeRank(key);
+    }
+
+    const char *check(const ReferenceTree &reference) {
+        int height = tree.getRoot() == nullptr ? -1 : tree.getRoot()->height;
+        if (!tree.checkInvariants() || !sameContent(tree, reference) ||
+            height > 2 * std::log2((double) reference.size() + 1))
+            return "invariants";
+        return checkTopK(tree, reference, MAX_TOP_K) ? nullptr : "topK";
+    }
+};
+
+// the data pointer found for a key must not change while the key lives
+struct IndexedTreeAdapter : StressAdapter {
+    const char *name = "indexed tree";
+    int key_space;
+    int mix[STRESS_OPERATIONS_NUMBER] = {6, 4, 2, 4, 0, 0};
+    IndexedTree<int> tree;
+    std::unordered_map<int, const int *> handles;
+
+    explicit IndexedTreeAdapter(long long operations) : key_space((int) std::max(16LL, operations / 2)) {}
+
+    void insert(int key, int data) {
+        tree.insert(key, data);
+        if (handles.count(key) == 0)
+            handles[key] = tree.find(key);
+    }
+
+    void remove(int key) {
+        tree.remove(key);
+        handles.erase(key);
+    }
+
+    void upgradeRank(int key_1, int key_2, int amount) {
+        tree.upgradeRank(key_1, key_2, amount);
+    }
+
+    const int *findData(int key) {
+        return tree.find(key);
+    }
+
+    double getNodeRank(int key) {
+        return tree.getNodeRank(key);
+    }
+
+    bool checkFound(int key, const int *data) {
+        return data == handles[key];
+    }
+
+    const char *check(const ReferenceTree &reference) {
+        return tree.getTree().checkInvariants() && sameContent(tree.getTree(), reference) ? nullptr : "content";
+    }
+};
+
+bool stressHashTable(long long operations, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> keys(-(int) std::min(operations, 1LL << 30), (int) std::min(operations, 1LL << 30));
+    std::uniform_int_distribution<int> types(0, 3);
+    HashTable<int> table;
+    std::unordered_map<int, int> reference;
+
+    for (long long i = 1; i <= operations; i++) {
+        int key = keys(generator);
+        int type = types(generator);
+        if (type < 2) {
+            table.insert(key, (int) i);
+            reference.insert(std::make_pair(key, (int) i));
+        }
+        else if (type == 2) {
+            table.remove(key);
+            reference.erase(key);
+        }
+        else {
+            auto expected = reference.find(key);
+            if (table.nodeExist(key) != (expected != reference.end()) ||
+                (expected != reference.end() && table.getData(key) != expected->second)) {
+                std::cout << "fail (hash table lookup " << key << " at operation " << i << ")" << std::endl;
+                return false;
+            }
+        }
+    }
+    if (table.getNodesCounter() != (int) reference.size()) {
+        std::cout << "fail (hash table size)" << std::endl;
+        return false;
+    }
+    // drain: the table must shrink back while every remaining key stays reachable
+    long long removed = 0;
+    for (auto it = reference.begin(); it != reference.end(); it = reference.erase(it), removed++) {
+        if (removed % 64 == 0 && (!table.nodeExist(it->first) || table.getData(it->first) != it->second)) {
+            std::cout << "fail (hash table drain lookup " << it->first << ")" << std::endl;
+            return false;
+        }
+        table.remove(it->first);
+    }
+    if (table.getNodesCounter() != 0 || table.getHashSize() > 4 * INITIAL_HASH_SIZE) {
+        std::cout << "fail (hash table shrink, " << table.getHashSize() << " buckets left)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// trees and tables in background destruction mode hand their old content to the reclaimer thread on
+// buildFromSorted, move assignment and destruction, while the replacing content stays intact
+bool checkBackgroundDestruction(int size) {
+    long long retired_before = BackgroundReclaimer::instance().getRetiredCounter();
+    std::vector<int> keys(size);
+    for (int i = 0; i < size; i++)
+        keys[i] = i;
+    {
+        BackgroundTree tree;
+        tree.setBackgroundDestruction(true);
+        for (int i = 0; i < size; i++)
+            tree.insert(keys[i], -keys[i]);
+        tree.buildFromSorted(keys.data(), keys.data(), nullptr, size); // retires the inserted nodes
+        BackgroundTree replacement;
+        replacement.insert(size, size);
+        tree = std::move(replacement); // retires the built nodes, then takes the inline mode of "replacement"
+        if (tree.getNodeCounter() != 1 || tree.find(size) == nullptr || !tree.checkInvariants())
+            return false;
+        BackgroundTree background_replacement;
+        background_replacement.setBackgroundDestruction(true);
+        background_replacement.insert(size + 1, size + 1);
+        tree = std::move(background_replacement); // frees the replacement node inline, takes the background mode
+        auto *table = new HashTable<int>;
+        table->setBackgroundDestruction(true);
+        for (int i = 0; i < size; i++)
+            table->insert(keys[i], keys[i]);
+        std::vector<uint64_t> empty_offsets(HashTable<int>::hashSizeFor(0) + 1, 0);
+        table->buildFromSorted(HashTable<int>::hashSizeFor(0), empty_offsets.data(), nullptr, nullptr); // retires
+        if (table->getNodesCounter() != 0 || table->find(keys[0]) != nullptr)
+            return false;
+        delete table; // retires the buckets
+    } // retires the background replacement node
+    BackgroundReclaimer::instance().drain();
+    return BackgroundReclaimer::instance().getRetiredCounter() - retired_before == 5;
+}
+
+// the table holds copies of one shared string, none of them may outlive the table
+bool checkOwnedData(int size) {
+    auto owner = std::make_shared<std::string>("a string too long for the small string buffer");
+    {
+        HashTable<std::shared_ptr<std::string>> table;
+        for (int key = 0; key < size; key++)
+            table.insert(key, owner);
+        table.finishRehash();
+        if (table.getNodesCounter() != size || *table.getData(size / 2) != *owner ||
+            owner.use_count() != size + 1)
+            return false;
+        // removes shrink the buckets back inline and the table to fewer buckets, a removed entry lets go at once
+        for (int key = 0; key < size; key++) {
+            if (key % 8 != 0)
+                table.remove(key);
+            if (key % 64 == 0 && owner.use_count() != table.getNodesCounter() + 1)
+                return false;
+        }
+        table.finishRehash();
+        if (owner.use_count() != table.getNodesCounter() + 1)
+            return false;
+    }
+    return owner.use_count() == 1;
+}
+
+bool stressShardedHashTable(long long operations, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> keys(-(int) std::min(operations, 1LL << 30), (int) std::min(operations, 1LL << 30));
+    std::vector<int> thread_keys(operations / 2), bulk_keys(operations / 2), queries(operations / 2);
+    for (size_t i = 0; i < thread_keys.size(); i++) {
+        thread_keys[i] = keys(generator);
+        bulk_keys[i] = keys(generator);
+        queries[i] = keys(generator);
+    }
+    ShardedHashTable<int> table(8);
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < SHARDED_THREADS; thread++) {
+        threads.emplace_back([&table, &thread_keys, thread]() {
+            for (size_t i = thread; i < thread_keys.size(); i += SHARDED_THREADS)
+                table.insert(thread_keys[i], -thread_keys[i]);
+        });
+    }
+    for (std::thread &thread: threads)
+        thread.join();
+    std::vector<int> bulk_data(bulk_keys.size());
+    for (size_t i = 0; i < bulk_keys.size(); i++)
+        bulk_data[i] = -bulk_keys[i];
+    table.insertBulk(bulk_keys.data(), bulk_data.data(), (int) bulk_keys.size(), SHARDED_THREADS);
+
+    std::unordered_map<int, int> reference;
+    for (int key: thread_keys)
+        reference.insert(std::make_pair(key, -key));
+    for (int key: bulk_keys)
+        reference.insert(std::make_pair(key, -key));
+    if (table.getNodesCounter() != (int) reference.size())
+        return false;
+    std::unique_ptr<bool[]> found(new bool[queries.size()]);
+    table.nodeExistBulk(queries.data(), found.get(), (int) queries.size(), SHARDED_THREADS);
+    for (size_t i = 0; i < queries.size(); i++) {
+        bool expected = reference.count(queries[i]) == 1;
+        if (found[i] != expected || table.nodeExist(queries[i]) != expected ||
+            (expected && table.getData(queries[i]) != -queries[i]))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    long long operations = argc > 1 ? atoll(argv[1]) : DEFAULT_NUMBER_OF_OPERATIONS;
+    unsigned int seed = argc > 2 ? (unsigned int) atoi(argv[2]) : DEFAULT_SEED;
+
+    std::cout << "Ranked tree stress test, " << operations << " operations, seed " << seed << ": ";
+    auto start = std::chrono::steady_clock::now();
+    RankedTreeAdapter<double> ranked_tree(operations, seed, false);
+    if (!stressTree(ranked_tree, operations, seed))
+        return 1;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "pass (" << operations / seconds / 1e6 << " M ops/s)" << std::endl;
+
+    std::cout << "Ranked tree compact / topK / freeze / set operations, " << operations / 4 << " operations: ";
+    RankedTreeAdapter<double> extended_tree(operations / 4, seed, true);
+    if (!stressTree(extended_tree, operations / 4, seed))
+        return 1;
+    std::cout << "pass" << std::endl;
+
+    std::cout << "Ranked tree int64_t / FixedPoint ranks, " << operations / 4 << " operations: ";
+    RankedTreeAdapter<int64_t> int64_tree(operations / 4, seed, true);
+    RankedTreeAdapter<FixedRank> fixed_point_tree(operations / 4, seed, true);
+    if (!stressTree(int64_tree, operations / 4, seed) || !stressTree(fixed_point_tree, operations / 4, seed))
+        return 1;
+    std::cout << "pass" << std::endl;
+
+    std::cout << "Persistent tree stress test, " << operations << " operations, seed " << seed << ": ";
+    start = std::chrono::steady_clock::now();
+    PersistentTreeAdapter persistent_tree(operations);
+    if (!stressTree(persistent_tree, operations, seed))
+        return 1;
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "pass (" << operations / seconds / 1e6 << " M ops/s)" << std::endl;
+
+    std::cout << "WAVL tree stress test, " << operations << " operations, seed " << seed << ": ";
+    start = std::chrono::steady_clock::now();
+    WeakAvlTreeAdapter weak_avl_tree(operations);
+    if (!stressTree(weak_avl_tree, operations, seed))
+        return 1;
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "pass (" << operations / seconds / 1e6 << " M ops/s)" << std::endl;
+
+    std::cout << "Indexed tree stress test, " << operations / 2 << " operations, seed " << seed << ": ";
+    start = std::chrono::steady_clock::now();
+    IndexedTreeAdapter indexed_tree(operations / 2);
+    if (!stressTree(indexed_tree, operations / 2, seed))
+        return 1;
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "pass (" << operations / 2 / seconds / 1e6 << " M ops/s)" << std::endl;
+
+    std::cout << "Fixed tree stress test, " << operations << " operations, seed " << seed << ": ";
+    start = std::chrono::steady_clock::now();
+    FixedTreeAdapter fixed_tree;
+    if (!stressTree(fixed_tree, operations, seed))
+        return 1;
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "pass (" << operations / seconds / 1e6 << " M ops/s)" << std::endl;
+
+    std::cout << "Hash table stress test, " << operations << " operations, seed " << seed << ": ";
+    start = std::chrono::steady_clock::now();
+    if (!stressHashTable(operations, seed))
+        return 1;
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "pass (" << operations / seconds / 1e6 << " M ops/s)" << std::endl;
+
+    std::cout << "Background destruction: ";
+    if (!checkBackgroundDestruction((int) std::min(operations, 1LL << 20))) {
+        std::cout << "fail (background destruction)" << std::endl;
+        return 1;
+    }
+    std::cout << "pass" << std::endl;
+
+    std::cout << "Hash table rehash of owning data: ";
+    if (!checkOwnedData(1000)) {
+        std::cout << "fail (hash table data copies leaked)" << std::endl;
+        return 1;
+    }
+    std::cout << "pass" << std::endl;
+
+    std::cout << "Sharded hash table stress test, " << operations << " operations, seed " << seed << ": ";
+    if (!stressShardedHashTable(operations, seed)) {
+        std::cout << "fail (sharded hash table content)" << std::endl;
+        return 1;
+    }
+    std::cout << "pass" << std::endl;
+    return 0;
+}
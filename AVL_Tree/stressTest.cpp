@@ -0,0 +1,80 @@
+
+// -------------------- LIBRARIES --------------------
+#include <iostream>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+// -------------------- DEBUG ON! --------------------
+#define DEBUG_ON
+
+// ------------------ INCLUDE FILES ------------------
+#include "AVLTree.h"
+#include "AVLTree.cpp"
+
+// --------------------- DEFINES ---------------------
+#define DEFAULT_NUMBER_OF_OPERATIONS 1000000
+#define DEFAULT_SEED 234218
+#define CHECK_INTERVAL 100000
+
+// --------------------- READ ME ---------------------
+// Randomized differential test of the plain AVL Tree against std::map.
+// Every operation is checked against the reference, the AVL invariants and the whole key set
+// are checked every CHECK_INTERVAL operations and at the end. Reports operations per second.
+// Usage: stress_test [number_of_operations] [seed]
+
+bool sameKeys(const Tree<int, int> &tree, const std::map<int, int> &reference) {
+    std::vector<int> keys = tree.returnKeysVector();
+    if (keys.size() != reference.size())
+        return false;
+    int i = 0;
+    for (const auto &entry: reference) {
+        if (keys[i++] != entry.first)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    long long operations = argc > 1 ? atoll(argv[1]) : DEFAULT_NUMBER_OF_OPERATIONS;
+    unsigned int seed = argc > 2 ? (unsigned int) atoi(argv[2]) : DEFAULT_SEED;
+    std::cout << "Stress test, " << operations << " operations, seed " << seed << ": ";
+
+    // the key space grows with the run so the tree reaches a size proportional to the operations
+    int key_space = (int) std::max(16LL, operations / 2);
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> keys(0, key_space);
+    std::uniform_int_distribution<int> types(0, 9);
+    Tree<int, int> tree;
+    std::map<int, int> reference;
+
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 1; i <= operations; i++) {
+        int key = keys(generator);
+        int type = types(generator);
+        if (type < 5) {
+            tree.insert(key, (int) i);
+            reference.insert(std::make_pair(key, (int) i));
+        }
+        else if (type < 8) {
+            tree.remove(key);
+            reference.erase(key);
+        }
+        else if (tree.nodeExist(key) != (reference.count(key) == 1)) {
+            std::cout << "fail (find " << key << " at operation " << i << ")" << std::endl;
+            return 1;
+        }
+        if (i % CHECK_INTERVAL == 0 || i == operations) {
+            if (!tree.checkInvariants() || !sameKeys(tree, reference)) {
+                std::cout << "fail (invariants at operation " << i << ")" << std::endl;
+                return 1;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "pass (" << reference.size() << " nodes, " << operations / seconds / 1e6 << " M ops/s)"
+              << std::endl;
+    return 0;
+}
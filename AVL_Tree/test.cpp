@@ -1,6 +1,8 @@
 
 // -------------------- LIBRARIES --------------------
 #include <iostream>
+#include <vector>
+#include <algorithm>
 #include <map>
 
 // -------------------- DEBUG ON! --------------------
@@ -15,6 +17,19 @@
 #define NUMBER_OF_TREES 500
 
 // ------------------ TEST FUNCTIONS ------------------
+// removes vec[0], vec[n], vec[2n], ... from the tree and returns the keys that were kept, in order.
+// same result as erasing every removed key from the middle of the vector, in one linear pass.
+std::vector<int> removeEveryNth(Tree<int, int> &avlTree, const std::vector<int> &vec, int n) {
+    std::vector<int> kept;
+    for (int i = 0; i < vec.size(); i++) {
+        if (i % n == 0)
+            avlTree.remove(vec[i]);
+        else
+            kept.push_back(vec[i]);
+    }
+    return kept;
+}
+
 void checkInsertAndDelete() {
     std::cout << "Check if insert and delete are working: ";
     for (int j = 0; j < NUMBER_OF_TREES; j++) {
@@ -25,8 +40,8 @@ void checkInsertAndDelete() {
             int b = rand();
             vec.push_back(a);
             avlTree.insert(a, b);
-            std::sort(vec.begin(), vec.end());
         }
+        std::sort(vec.begin(), vec.end());
         std::vector<int> avl_vec = avlTree.returnKeysVector();
         for (int i = 0; i < vec.size(); i++) {
             if (vec[i] != avl_vec[i]) {
@@ -34,10 +49,7 @@ void checkInsertAndDelete() {
                 return;
             }
         }
-        for (int i = 0; i < vec.size(); i += j) {
-            avlTree.remove(vec[i]);
-            vec.erase(vec.begin() + i);
-        }
+        vec = removeEveryNth(avlTree, vec, j + 1);
         avl_vec = avlTree.returnKeysVector();
 
         for (int i = 0; i < vec.size(); i++) {
@@ -62,12 +74,9 @@ void checkNodeData() {
             vec.push_back(a);
             map_t.insert(std::make_pair(a, b));
             avlTree.insert(a, b);
-            std::sort(vec.begin(), vec.end());
-        }
-        for (int i = 0; i < vec.size(); i += j + 1) {
-            avlTree.remove(vec[i]);
-            vec.erase(vec.begin() + i);
         }
+        std::sort(vec.begin(), vec.end());
+        vec = removeEveryNth(avlTree, vec, j + 2);
         std::vector<int> avl_vec = avlTree.returnKeysVector();
 
         for (int &i: vec) {
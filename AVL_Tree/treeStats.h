@@ -0,0 +1,143 @@
+#ifndef TREE_STATS_H
+#define TREE_STATS_H
+
+// --------------------- READ ME ---------------------
+// Optional performance counters of the trees and the hash table, compiled in only with AVL_STATS_ON.
+// Without AVL_STATS_ON every AVL_STATS_ADD compiles to nothing and no stats function exists.
+// Every thread counts into its own counters (relaxed atomic load + store, no locked instruction),
+// readers sum the counters of the live threads and of the threads that already exited.
+// Functions: statsTotal - current total of a counter, dumpTreeStats - JSON object of every counter,
+// resetTreeStats - zero every counter (counts racing with the reset may be lost).
+
+#ifdef AVL_STATS_ON
+
+// -------------------- LIBRARIES --------------------
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <ostream>
+#include <algorithm>
+
+enum TreeStatsCounter {
+    STATS_LL_ROTATIONS,
+    STATS_RR_ROTATIONS,
+    STATS_LR_ROTATIONS,
+    STATS_RL_ROTATIONS,
+    STATS_LOOKUPS,
+    STATS_LOOKUP_NODES_VISITED,
+    STATS_ALLOCATIONS,
+    STATS_DEALLOCATIONS,
+    STATS_REHASHES,
+    STATS_REHASH_NANOSECONDS,
+    STATS_COUNTERS_NUMBER
+};
+
+static const char *const TREE_STATS_NAMES[STATS_COUNTERS_NUMBER] = {
+        "ll_rotations", "rr_rotations", "lr_rotations", "rl_rotations", "lookups", "lookup_nodes_visited",
+        "allocations", "deallocations", "rehashes", "rehash_ns"
+};
+
+struct TreeStatsCounters {
+    std::atomic<long long> values[STATS_COUNTERS_NUMBER];
+
+    TreeStatsCounters() {
+        for (auto &value: values)
+            value.store(0, std::memory_order_relaxed);
+    }
+};
+
+// ----------------- STATS REGISTRY -----------------
+class TreeStatsRegistry {
+private:
+    std::mutex lock;
+    std::vector<TreeStatsCounters *> threads;
+    long long retired[STATS_COUNTERS_NUMBER] = {};
+
+public:
+    void add(TreeStatsCounters *counters) {
+        std::lock_guard<std::mutex> guard(lock);
+        threads.push_back(counters);
+    }
+
+    void retire(TreeStatsCounters *counters) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (int i = 0; i < STATS_COUNTERS_NUMBER; i++)
+            retired[i] += counters->values[i].load(std::memory_order_relaxed);
+        threads.erase(std::find(threads.begin(), threads.end(), counters));
+    }
+
+    long long total(TreeStatsCounter counter) {
+        std::lock_guard<std::mutex> guard(lock);
+        long long sum = retired[counter];
+        for (TreeStatsCounters *counters: threads)
+            sum += counters->values[counter].load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> guard(lock);
+        for (int i = 0; i < STATS_COUNTERS_NUMBER; i++) {
+            retired[i] = 0;
+            for (TreeStatsCounters *counters: threads)
+                counters->values[i].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+inline TreeStatsRegistry &treeStatsRegistry() {
+    static TreeStatsRegistry registry;
+    return registry;
+}
+
+class ThreadTreeStats {
+public:
+    TreeStatsCounters counters;
+
+    ThreadTreeStats() {
+        treeStatsRegistry().add(&counters);
+    }
+
+    ~ThreadTreeStats() {
+        treeStatsRegistry().retire(&counters);
+    }
+};
+
+inline void statsAdd(TreeStatsCounter counter, long long amount) {
+    static thread_local ThreadTreeStats thread_stats;
+    std::atomic<long long> &value = thread_stats.counters.values[counter];
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+inline long long statsTotal(TreeStatsCounter counter) {
+    return treeStatsRegistry().total(counter);
+}
+
+inline void resetTreeStats() {
+    treeStatsRegistry().reset();
+}
+
+// writes the counters as the members of a JSON object, without the braces
+inline void dumpTreeStatsMembers(std::ostream &stream) {
+    for (int i = 0; i < STATS_COUNTERS_NUMBER; i++) {
+        stream << "\"" << TREE_STATS_NAMES[i] << "\": " << statsTotal((TreeStatsCounter) i)
+               << (i + 1 < STATS_COUNTERS_NUMBER ? ", " : "");
+    }
+}
+
+inline void dumpTreeStats(std::ostream &stream) {
+    stream << "{";
+    dumpTreeStatsMembers(stream);
+    stream << "}";
+}
+
+#define AVL_STATS_ADD(counter, amount) statsAdd(counter, amount)
+
+#else
+
+// "amount" stays unevaluated, it is only named so locals kept for the counters do not warn
+#define AVL_STATS_ADD(counter, amount) ((void) sizeof(amount))
+
+#endif /* AVL_STATS_ON */
+
+#endif /* TREE_STATS_H */
@@ -0,0 +1,47 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../AVL_Tree/AVLTree.h"
+#include "../AVL_Tree/AVLTree.cpp"
+
+// --------------------- READ ME ---------------------
+// Benchmarks of the plain AVL Tree: insert, find (nodeExist) and remove over every size and distribution.
+// Usage: avl_tree_bench [--max-size N] [--output FILE]
+
+void benchTree(BenchResults &results, KeyDistribution distribution, int size) {
+    const char *name = distributionName(distribution);
+    std::vector<int> keys = makeKeys(distribution, size);
+    std::vector<int> queries = makeKeys(distribution, size, BENCH_SEED + 1);
+    Tree<int, int> tree;
+
+    BenchTimer insert_timer;
+    for (int key: keys)
+        tree.insert(key, key);
+    results.add("tree", "insert", name, size, size, insert_timer.nanoseconds());
+
+    BenchTimer find_timer;
+    int found = 0;
+    for (int key: queries)
+        found += tree.nodeExist(key);
+    benchKeep(found);
+    results.add("tree", "find", name, size, size, find_timer.nanoseconds());
+
+    BenchTimer remove_timer;
+    for (int key: keys)
+        tree.remove(key);
+    results.add("tree", "remove", name, size, size, remove_timer.nanoseconds());
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes()) {
+        for (KeyDistribution distribution: ALL_DISTRIBUTIONS)
+            benchTree(results, distribution, size);
+    }
+    results.write(options.output);
+    return 0;
+}
@@ -0,0 +1,49 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../hashTable.h"
+
+// --------------------- READ ME ---------------------
+// Pause of the owner thread when a big ranked Tree or HashTable is destroyed: freeing on the owner thread
+// against background destruction mode, which hands the content to the BackgroundReclaimer thread.
+// The time the reclaimer then needs to free it is reported as the "reclaim_ns" metric. On a single core the
+// reclaimer competes with the owner thread, so the background timings include some of its work.
+// Usage: background_destruction_bench [--max-size N] [--output FILE]
+
+typedef Tree<int, int, double, AVLBalance, NoRankAugment, BackgroundStorage> BackgroundTree;
+
+template<class structureType>
+void benchDestruction(BenchResults &results, const std::string &structure, const std::vector<int> &keys,
+                      bool background) {
+    int size = (int) keys.size();
+    auto *instance = new structureType;
+    instance->setBackgroundDestruction(background);
+    for (int key: keys)
+        instance->insert(key, key);
+    std::string name = structure + (background ? "_background" : "_inline");
+    BenchTimer destroy_timer;
+    delete instance;
+    results.add(name, "destroy", "uniform", size, 1, destroy_timer.nanoseconds());
+    BenchTimer reclaim_timer;
+    BackgroundReclaimer::instance().drain();
+    if (background)
+        results.addMetric(name, "reclaim_ns", size, reclaim_timer.nanoseconds());
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    BackgroundReclaimer::instance(); // starts the reclaimer thread outside of the timings
+    for (int size: options.sizes()) {
+        std::vector<int> keys = makeKeys(UNIFORM, size);
+        for (bool background: {false, true}) {
+            benchDestruction<BackgroundTree>(results, "ranked_tree", keys, background);
+            benchDestruction<HashTable<int>>(results, "hash_table", keys, background);
+        }
+    }
+    results.write(options.output);
+    return 0;
+}
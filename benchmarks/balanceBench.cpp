@@ -0,0 +1,77 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+#include <random>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../AVL_Tree/rankedAVLTree.h"
+
+// --------------------- READ ME ---------------------
+// Balance policies of the ranked Tree: AVLBalance against WAVLBalance on insert heavy, delete heavy and
+// lookup heavy mixes of random keys, after prefilling the tree with "size" keys.
+// Reports the throughput and the rotations per operation (built with AVL_STATS_ON for the rotation counters,
+// both policies pay the same counting cost).
+// Usage: balance_bench [--max-size N] [--output FILE]
+
+struct OperationMix {
+    const char *name;
+    int insert_percent;
+    int remove_percent; // the rest are finds
+};
+
+static const OperationMix MIXES[] = {
+        {"insert_heavy", 70, 20},
+        {"delete_heavy", 20, 70},
+        {"lookup_heavy", 10, 10}
+};
+
+static long long totalRotations() {
+    return statsTotal(STATS_LL_ROTATIONS) + statsTotal(STATS_RR_ROTATIONS) + statsTotal(STATS_LR_ROTATIONS) +
+           statsTotal(STATS_RL_ROTATIONS);
+}
+
+template<class balancePolicy>
+void benchMix(BenchResults &results, const OperationMix &mix, int size) {
+    std::mt19937 generator(BENCH_SEED);
+    std::uniform_int_distribution<int> keys(0, 2 * size);
+    std::uniform_int_distribution<int> percents(0, 99);
+    Tree<int, int, double, balancePolicy> tree;
+    for (int i = 0; i < size; i++)
+        tree.insert(keys(generator), i);
+    std::vector<int> operation_keys(size), operation_types(size);
+    for (int i = 0; i < size; i++) {
+        operation_keys[i] = keys(generator);
+        operation_types[i] = percents(generator);
+    }
+
+    resetTreeStats();
+    long long found = 0;
+    BenchTimer timer;
+    for (int i = 0; i < size; i++) {
+        if (operation_types[i] < mix.insert_percent)
+            tree.insert(operation_keys[i], i);
+        else if (operation_types[i] < mix.insert_percent + mix.remove_percent)
+            tree.remove(operation_keys[i]);
+        else
+            found += tree.find(operation_keys[i]) != nullptr;
+    }
+    std::string structure = std::string("ranked_tree_") + balancePolicy::name;
+    results.add(structure, mix.name, "uniform", size, size, timer.nanoseconds());
+    results.addMetric(structure, std::string("rotations_per_op_") + mix.name, size,
+                      (double) totalRotations() / size);
+    benchKeep(found);
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes()) {
+        for (const OperationMix &mix: MIXES) {
+            benchMix<AVLBalance>(results, mix, size);
+            benchMix<WAVLBalance>(results, mix, size);
+        }
+    }
+    results.write(options.output);
+    return 0;
+}
@@ -0,0 +1,200 @@
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+// -------------------- LIBRARIES --------------------
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+// -------------------- DEFINES --------------------
+#define BENCH_MIN_SIZE 1000
+#define BENCH_DEFAULT_MAX_SIZE 1000000
+#define BENCH_SEED 234218
+#define BENCH_ZIPF_EXPONENT 0.99
+#define BENCH_KEY_HEADROOM (1 << 16) // generated keys leave room for "key + width" ranges below INT_MAX
+#define BENCH_MAX_KEY (INT_MAX - BENCH_KEY_HEADROOM)
+
+// --------------------- READ ME ---------------------
+// Shared helpers of the benchmark suite: key distributions, timing and JSON output.
+// Every benchmark accepts: --max-size N (sizes run from 1K up to N by powers of 10, at most 10M)
+// and --output FILE (JSON result array, stdout by default).
+// Distributions of the operated keys:
+// sequential - 0, 1, 2, ... (ascending inserts, every insert hits the rightmost path).
+// uniform - uniformly random keys over [0, BENCH_MAX_KEY].
+// zipfian - ranks drawn with exponent 0.99 over n distinct keys, scrambled so hot keys are spread.
+// alternating - keys taken alternately from both ends of the range, keeping rotations on both edges busy.
+// colliding (makeCollidingKeys) - keys piled into the fewest buckets of a key % size hash table.
+
+typedef std::chrono::steady_clock benchClock;
+
+enum KeyDistribution {
+    SEQUENTIAL,
+    UNIFORM,
+    ZIPFIAN,
+    ALTERNATING
+};
+
+static const KeyDistribution ALL_DISTRIBUTIONS[] = {SEQUENTIAL, UNIFORM, ZIPFIAN, ALTERNATING};
+
+static inline const char *distributionName(KeyDistribution distribution) {
+    switch (distribution) {
+        case SEQUENTIAL:
+            return "sequential";
+        case UNIFORM:
+            return "uniform";
+        case ZIPFIAN:
+            return "zipfian";
+        default:
+            return "alternating";
+    }
+}
+
+// bijective scramble of [0, 2^31) so that neighbouring zipf ranks land far apart
+static inline int scrambleKey(unsigned int value) {
+    value = (value ^ (value >> 16)) * 0x45d9f3bu;
+    value = (value ^ (value >> 16)) * 0x45d9f3bu;
+    value ^= value >> 16;
+    return (int) (value & 0x7fffffffu);
+}
+
+static inline std::vector<int> makeKeys(KeyDistribution distribution, int size, unsigned int seed = BENCH_SEED) {
+    std::vector<int> keys(size);
+    std::mt19937 generator(seed);
+    if (distribution == SEQUENTIAL) {
+        for (int i = 0; i < size; i++)
+            keys[i] = i;
+    }
+    else if (distribution == UNIFORM) {
+        std::uniform_int_distribution<int> uniform(0, BENCH_MAX_KEY);
+        for (int i = 0; i < size; i++)
+            keys[i] = uniform(generator);
+    }
+    else if (distribution == ZIPFIAN) {
+        // inverse transform over the cumulative distribution of the ranks
+        std::vector<double> cumulative(size);
+        double sum = 0;
+        for (int i = 0; i < size; i++) {
+            sum += 1.0 / std::pow(i + 1, BENCH_ZIPF_EXPONENT);
+            cumulative[i] = sum;
+        }
+        std::uniform_real_distribution<double> uniform(0, sum);
+        for (int i = 0; i < size; i++) {
+            int rank = (int) (std::lower_bound(cumulative.begin(), cumulative.end(), uniform(generator)) -
+                              cumulative.begin());
+            keys[i] = scrambleKey((unsigned int) std::min(rank, size - 1)) % (BENCH_MAX_KEY + 1);
+        }
+    }
+    else {
+        int low = 0, high = size - 1;
+        for (int i = 0; i < size; i++)
+            keys[i] = i % 2 == 0 ? high-- : low++;
+    }
+    return keys;
+}
+
+// keys sharing the fewest remainders modulo "hash_size" (the bucket count of a key % size hash table), as many
+// per remainder as [0, BENCH_MAX_KEY] holds, in a random order
+static inline std::vector<int> makeCollidingKeys(int size, int hash_size, unsigned int seed = BENCH_SEED) {
+    std::vector<int> keys;
+    keys.reserve(size);
+    for (long long remainder = 0; (int) keys.size() < size; remainder++) {
+        for (long long key = remainder; key <= BENCH_MAX_KEY && (int) keys.size() < size; key += hash_size)
+            keys.push_back((int) key);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(seed));
+    return keys;
+}
+
+// ---------------- BENCHMARK OPTIONS ----------------
+struct BenchOptions {
+    long long max_size;
+    std::string output;
+
+    BenchOptions(int argc, char *argv[]) : max_size(BENCH_DEFAULT_MAX_SIZE) {
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc)
+                max_size = atoll(argv[++i]);
+            else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+                output = argv[++i];
+        }
+    }
+
+    std::vector<int> sizes() const {
+        std::vector<int> result;
+        for (long long size = BENCH_MIN_SIZE; size <= max_size && size <= 10000000; size *= 10)
+            result.push_back((int) size);
+        return result;
+    }
+};
+
+// ----------------- BENCHMARK TIMER -----------------
+class BenchTimer {
+private:
+    benchClock::time_point start;
+
+public:
+    BenchTimer() : start(benchClock::now()) {}
+
+    double nanoseconds() const {
+        return std::chrono::duration<double, std::nano>(benchClock::now() - start).count();
+    }
+};
+
+// ---------------- BENCHMARK RESULTS ----------------
+// collects one JSON object per measurement and writes them as a JSON array.
+class BenchResults {
+private:
+    std::vector<std::string> records;
+
+public:
+    void add(const std::string &structure, const std::string &operation, const char *distribution, int size,
+             long long operations, double nanoseconds) {
+        std::ostringstream record;
+        double ns_per_operation = operations > 0 ? nanoseconds / (double) operations : 0;
+        record << "{\"structure\": \"" << structure << "\", \"operation\": \"" << operation
+               << "\", \"distribution\": \"" << distribution << "\", \"size\": " << size
+               << ", \"operations\": " << operations << ", \"total_ns\": " << (long long) nanoseconds
+               << ", \"ns_per_op\": " << ns_per_operation
+               << ", \"ops_per_sec\": " << (ns_per_operation > 0 ? 1e9 / ns_per_operation : 0) << "}";
+        records.push_back(record.str());
+        std::cerr << structure << " " << operation << " " << distribution << " n=" << size << ": "
+                  << ns_per_operation << " ns/op" << std::endl;
+    }
+
+    // a measured quantity that is not a timing, e.g. bytes per node
+    void addMetric(const std::string &structure, const std::string &metric, int size, double value) {
+        std::ostringstream record;
+        record << "{\"structure\": \"" << structure << "\", \"metric\": \"" << metric << "\", \"size\": " << size
+               << ", \"value\": " << value << "}";
+        records.push_back(record.str());
+        std::cerr << structure << " " << metric << " n=" << size << ": " << value << std::endl;
+    }
+
+    void write(const std::string &output) const {
+        std::ofstream file;
+        if (!output.empty())
+            file.open(output);
+        std::ostream &stream = output.empty() ? std::cout : file;
+        stream << "[" << std::endl;
+        for (size_t i = 0; i < records.size(); i++)
+            stream << "  " << records[i] << (i + 1 < records.size() ? "," : "") << std::endl;
+        stream << "]" << std::endl;
+    }
+};
+
+// keeps the compiler from dropping a benchmarked result
+template<class valueType>
+static inline void benchKeep(const valueType &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif /* BENCH_UTILS_H */
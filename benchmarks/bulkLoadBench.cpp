@@ -0,0 +1,138 @@
+
+// -------------------- LIBRARIES --------------------
+#include <cstdio>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../bulkLoader.h"
+
+// --------------------- READ ME ---------------------
+// Loading a ranked Tree / HashTable from a csv or binary file of size records, from cold start: the file is
+// dropped from the page cache before every load. bulkLoad (on every hardware thread) against the baseline of
+// reading the file record by record (fscanf / fread) and inserting every record.
+// "sorted" files hold ascending keys (the O(n) tree build), "uniform" files hold random keys.
+// Reported as the time per record and as the "records_per_s" metric, the loaded structures are checked against
+// the baseline ones.
+// Usage: bulk_load_bench [--max-size N] [--output FILE]
+
+#define BULK_LOAD_PATH "bulk_load_bench.data"
+
+void writeRecords(const std::vector<int> &keys, LoaderFormat format) {
+    FILE *file = fopen(BULK_LOAD_PATH, "wb");
+    for (int key: keys) {
+        int data = key / 2;
+        if (format == LOADER_CSV)
+            fprintf(file, "%d,%d\n", key, data);
+        else {
+            fwrite(&key, sizeof(int), 1, file);
+            fwrite(&data, sizeof(int), 1, file);
+        }
+    }
+    fflush(file);
+    fsync(fileno(file));
+    fclose(file);
+}
+
+// drops the (already written back) file pages from the page cache, so the next load reads from the disk
+void dropCache() {
+    int fd = open(BULK_LOAD_PATH, O_RDONLY);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+template<class structureType>
+void insertRecords(structureType &structure, LoaderFormat format) {
+    FILE *file = fopen(BULK_LOAD_PATH, "rb");
+    int key, data;
+    if (format == LOADER_CSV) {
+        while (fscanf(file, "%d,%d", &key, &data) == 2)
+            structure.insert(key, data);
+    }
+    else {
+        while (fread(&key, sizeof(int), 1, file) == 1 && fread(&data, sizeof(int), 1, file) == 1)
+            structure.insert(key, data);
+    }
+    fclose(file);
+}
+
+static int entriesOf(const Tree<int, int> &tree) {
+    return tree.getNodeCounter();
+}
+
+static int entriesOf(const HashTable<int> &table) {
+    return table.getNodesCounter();
+}
+
+static int *dataOf(Tree<int, int> &tree, int key) {
+    Tree<int, int>::Node *node = tree.find(key);
+    return node == nullptr ? nullptr : &node->data;
+}
+
+static int *dataOf(HashTable<int> &table, int key) {
+    return table.find(key);
+}
+
+void report(BenchResults &results, const std::string &structure, const char *format, const char *distribution,
+            int size, double nanoseconds) {
+    results.add(structure, std::string("load_") + format, distribution, size, size, nanoseconds);
+    results.addMetric(structure, std::string("records_per_s_") + format + "_" + distribution, size,
+                      size / nanoseconds * 1e9);
+}
+
+template<class structureType>
+bool benchLoad(BenchResults &results, const std::string &structure, const std::vector<int> &keys,
+               LoaderFormat format, const char *distribution, int threads) {
+    int size = (int) keys.size();
+    const char *format_name = format == LOADER_CSV ? "csv" : "binary";
+
+    structureType inserted;
+    dropCache();
+    BenchTimer insert_timer;
+    insertRecords(inserted, format);
+    report(results, structure + "_insert", format_name, distribution, size, insert_timer.nanoseconds());
+
+    structureType loaded;
+    dropCache();
+    BenchTimer load_timer;
+    bulkLoad(loaded, BULK_LOAD_PATH, format, threads);
+    report(results, structure + "_bulk_load", format_name, distribution, size, load_timer.nanoseconds());
+
+    for (int key: keys) {
+        int *data = dataOf(loaded, key);
+        if (data == nullptr || *data != *dataOf(inserted, key))
+            return false;
+    }
+    return entriesOf(loaded) == entriesOf(inserted);
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    int threads = (int) std::max(1u, std::thread::hardware_concurrency());
+    for (int size: options.sizes()) {
+        std::vector<int> uniform_keys = makeKeys(UNIFORM, size);
+        std::vector<int> sorted_keys(uniform_keys);
+        std::sort(sorted_keys.begin(), sorted_keys.end());
+        sorted_keys.erase(std::unique(sorted_keys.begin(), sorted_keys.end()), sorted_keys.end());
+        for (LoaderFormat format: {LOADER_CSV, LOADER_BINARY}) {
+            for (const std::vector<int> *keys: {&sorted_keys, &uniform_keys}) {
+                const char *distribution = keys == &sorted_keys ? "sorted" : "uniform";
+                writeRecords(*keys, format);
+                if (!benchLoad<Tree<int, int>>(results, "ranked_tree", *keys, format, distribution, threads) ||
+                    !benchLoad<HashTable<int>>(results, "hash_table", *keys, format, distribution, threads)) {
+                    std::cerr << "bulk load mismatch" << std::endl;
+                    remove(BULK_LOAD_PATH);
+                    return 1;
+                }
+            }
+        }
+    }
+    remove(BULK_LOAD_PATH);
+    results.write(options.output);
+    return 0;
+}
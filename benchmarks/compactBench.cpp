@@ -0,0 +1,85 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+#include <random>
+#include <algorithm>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../AVL_Tree/rankedAVLTree.h"
+#include "../AVL_Tree/nodeArena.h"
+
+// --------------------- READ ME ---------------------
+// Node locality of a long lived ranked Tree: lookups and an in order export on a freshly built tree, after a
+// churn phase (CHURN_ROUNDS * size removes of random keys, each followed by an insert of a new key),
+// and after compacting it with compact(COMPACT_SLICE) calls, whose longest call is reported as well.
+// Usage: compact_bench [--max-size N] [--output FILE]
+
+#define CHURN_ROUNDS 4
+#define COMPACT_SLICE 1024
+
+typedef Tree<int, int, double, AVLBalance, NoRankAugment, ArenaStorage> ArenaTree; // compact needs the arena
+
+void benchPhase(BenchResults &results, const char *phase, ArenaTree &tree, const std::vector<int> &queries) {
+    long long found = 0;
+    BenchTimer find_timer;
+    for (int key: queries)
+        found += tree.find(key) != nullptr;
+    int size = tree.getNodeCounter();
+    results.add(std::string("ranked_tree_") + phase, "find", "uniform", size, (long long) queries.size(),
+                find_timer.nanoseconds());
+
+    std::vector<int> keys(size), data(size);
+    BenchTimer inorder_timer;
+    tree.exportInorder(keys.data(), data.data(), nullptr);
+    results.add(std::string("ranked_tree_") + phase, "export_inorder", "uniform", size, size,
+                inorder_timer.nanoseconds());
+    benchKeep(found + keys[size / 2]);
+}
+
+void benchCompact(BenchResults &results, int size) {
+    std::vector<int> keys(size);
+    for (int i = 0; i < size; i++)
+        keys[i] = 2 * i;
+    ArenaTree tree;
+    tree.buildFromSorted(keys.data(), keys.data(), nullptr, size);
+    std::mt19937 generator(BENCH_SEED);
+    std::vector<int> queries(keys);
+    std::shuffle(queries.begin(), queries.end(), generator);
+    benchPhase(results, "fresh", tree, queries);
+
+    // every round replaces a random live key by a new one, the tree keeps its size
+    std::vector<int> live(keys);
+    int next_key = 2 * size;
+    for (long long i = 0; i < (long long) CHURN_ROUNDS * size; i++) {
+        int &victim = live[generator() % size];
+        tree.remove(victim);
+        victim = next_key++;
+        tree.insert(victim, victim);
+    }
+    std::shuffle(live.begin(), live.end(), generator);
+    benchPhase(results, "churned", tree, live);
+
+    long long slices = 0, longest = 0;
+    BenchTimer compact_timer;
+    bool done = false;
+    while (!done) {
+        BenchTimer slice_timer;
+        done = tree.compact(COMPACT_SLICE);
+        longest = std::max(longest, (long long) slice_timer.nanoseconds());
+        slices++;
+    }
+    results.add("ranked_tree", "compact", "uniform", size, size, compact_timer.nanoseconds());
+    results.addMetric("ranked_tree", "compact_longest_slice_ns", size, (double) longest);
+    benchPhase(results, "compacted", tree, live);
+    benchKeep(slices);
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes())
+        benchCompact(results, size);
+    results.write(options.output);
+    return 0;
+}
@@ -0,0 +1,73 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../AVL_Tree/rankedAVLTree.h"
+#include "../AVL_Tree/fixedRankedTree.h"
+
+// --------------------- READ ME ---------------------
+// Latency distribution of single insert / find / remove calls: the heap allocating ranked Tree against
+// a FixedTree of the same capacity. Reports the mean (ns_per_op) and the p50 / p99 / p99.9 / max latency.
+// Usage: fixed_tree_bench [--max-size N] [--output FILE]
+
+void addLatencies(BenchResults &results, const char *structure, const char *operation, int size,
+                  std::vector<double> &latencies) {
+    double total = 0;
+    for (double latency: latencies)
+        total += latency;
+    results.add(structure, operation, "uniform", size, (long long) latencies.size(), total);
+    std::sort(latencies.begin(), latencies.end());
+    const char *names[] = {"_p50_ns", "_p99_ns", "_p999_ns", "_max_ns"};
+    double fractions[] = {0.5, 0.99, 0.999, 1};
+    for (int i = 0; i < 4; i++) {
+        size_t index = std::min(latencies.size() - 1, (size_t) (fractions[i] * (double) latencies.size()));
+        results.addMetric(structure, std::string(operation) + names[i], size, latencies[index]);
+    }
+}
+
+template<class treeType>
+void benchLatency(BenchResults &results, const char *structure, treeType &tree, int size) {
+    std::vector<int> keys = makeKeys(UNIFORM, size);
+    std::vector<double> latencies(keys.size());
+    const char *operations[] = {"insert", "find", "remove"};
+    for (int operation = 0; operation < 3; operation++) {
+        long long found = 0;
+        for (size_t i = 0; i < keys.size(); i++) {
+            BenchTimer timer;
+            if (operation == 0)
+                tree.insert(keys[i], keys[i]);
+            else if (operation == 1)
+                found += tree.find(keys[i]) != nullptr;
+            else
+                tree.remove(keys[i]);
+            latencies[i] = timer.nanoseconds();
+        }
+        benchKeep(found);
+        addLatencies(results, structure, operations[operation], size, latencies);
+    }
+}
+
+template<int capacity>
+void benchCapacity(BenchResults &results, const BenchOptions &options) {
+    if (capacity > options.max_size)
+        return;
+    Tree<int, int> tree;
+    benchLatency(results, "ranked_tree", tree, capacity);
+    std::unique_ptr<FixedTree<int, int, capacity>> fixed(new FixedTree<int, int, capacity>);
+    benchLatency(results, "fixed_tree", *fixed, capacity);
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    benchCapacity<1000>(results, options);
+    benchCapacity<10000>(results, options);
+    benchCapacity<100000>(results, options);
+    benchCapacity<1000000>(results, options);
+    results.write(options.output);
+    return 0;
+}
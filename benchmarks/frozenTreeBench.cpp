@@ -0,0 +1,74 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+#include <algorithm>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../AVL_Tree/frozenRankedTree.h"
+
+// --------------------- READ ME ---------------------
+// Read only lookups: the pointer based ranked Tree (built by random inserts, so nodes are scattered)
+// against its frozen Eytzinger copy, and std::lower_bound on a sorted array as a reference point.
+// Every query is a random key that exists. Sizes go up to 10M, far above the caches.
+// Usage: frozen_tree_bench [--max-size N] [--output FILE]
+
+void benchFrozen(BenchResults &results, int size) {
+    std::vector<int> keys = makeKeys(UNIFORM, size);
+    Tree<int, int> tree;
+    for (int key: keys)
+        tree.insert(key, key);
+    tree.upgradeRank(0, 1 << 30, 1);
+    FrozenTree<int, int> frozen = freeze(tree);
+    std::vector<int> sorted(keys);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    std::vector<int> queries = keys;
+    std::shuffle(queries.begin(), queries.end(), std::mt19937(BENCH_SEED + 1));
+
+    long long found = 0;
+    BenchTimer tree_timer;
+    for (int key: queries)
+        found += tree.find(key) != nullptr;
+    results.add("ranked_tree", "find", "uniform", size, size, tree_timer.nanoseconds());
+
+    BenchTimer frozen_timer;
+    for (int key: queries)
+        found += frozen.find(key) != nullptr;
+    results.add("frozen_tree", "find", "uniform", size, size, frozen_timer.nanoseconds());
+
+    BenchTimer lower_bound_timer;
+    for (int key: queries)
+        found += frozen.lowerBound(key);
+    results.add("frozen_tree", "lower_bound", "uniform", size, size, lower_bound_timer.nanoseconds());
+
+    BenchTimer sorted_timer;
+    for (int key: queries)
+        found += *std::lower_bound(sorted.begin(), sorted.end(), key);
+    results.add("sorted_array", "lower_bound", "uniform", size, size, sorted_timer.nanoseconds());
+
+    double rank_sum = 0;
+    BenchTimer tree_rank_timer;
+    for (int key: queries)
+        rank_sum += tree.getNodeRank(key);
+    results.add("ranked_tree", "get_node_rank", "uniform", size, size, tree_rank_timer.nanoseconds());
+
+    BenchTimer frozen_rank_timer;
+    for (int key: queries)
+        rank_sum -= frozen.getNodeRank(key);
+    results.add("frozen_tree", "get_node_rank", "uniform", size, size, frozen_rank_timer.nanoseconds());
+    benchKeep(found);
+    if (rank_sum != 0) {
+        std::cerr << "frozen ranks differ from the tree ranks" << std::endl;
+        exit(1);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes())
+        benchFrozen(results, size);
+    results.write(options.output);
+    return 0;
+}
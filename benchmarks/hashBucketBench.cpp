@@ -0,0 +1,56 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "heapCounter.h"
+#include "../hashTable.h"
+
+// --------------------- READ ME ---------------------
+// HashTable memory per entry and lookup latency with inline buckets (hash_bucket_bench) and with
+// a tree in every bucket (hash_bucket_bench_tree, built with BUCKET_INLINE_ENTRIES=0).
+// Memory is the heap held by the table, counted by heapCounter.h. "colliding" keys pile into few buckets.
+// Usage: hash_bucket_bench [--max-size N] [--output FILE]
+
+#if BUCKET_INLINE_ENTRIES > 0
+#define BENCH_STRUCTURE "hash_table_inline_buckets"
+#else
+#define BENCH_STRUCTURE "hash_table_tree_buckets"
+#endif
+
+void benchBuckets(BenchResults &results, const char *distribution, const std::vector<int> &keys) {
+    int size = (int) keys.size();
+    std::vector<int> misses = makeKeys(UNIFORM, size, BENCH_SEED + 1);
+    long long heap_before = heap_bytes;
+    auto *table = new HashTable<int>;
+    for (int key: keys)
+        table->insert(key, key);
+    results.addMetric(BENCH_STRUCTURE, std::string("bytes_per_entry_") + distribution, size,
+                      (double) (heap_bytes - heap_before) / table->getNodesCounter());
+
+    long long found = 0;
+    BenchTimer hit_timer;
+    for (int key: keys)
+        found += table->getData(key) == key;
+    results.add(BENCH_STRUCTURE, "lookup_hit", distribution, size, size, hit_timer.nanoseconds());
+
+    BenchTimer miss_timer;
+    for (int key: misses)
+        found += table->nodeExist(key);
+    results.add(BENCH_STRUCTURE, "lookup_any", distribution, size, size, miss_timer.nanoseconds());
+    benchKeep(found);
+    delete table;
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes()) {
+        for (KeyDistribution distribution: {SEQUENTIAL, UNIFORM})
+            benchBuckets(results, distributionName(distribution), makeKeys(distribution, size));
+        benchBuckets(results, "colliding", makeCollidingKeys(size, HashTable<int>::hashSizeFor(size)));
+    }
+    results.write(options.output);
+    return 0;
+}
@@ -0,0 +1,58 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "heapCounter.h"
+#include "../hashTable.h"
+
+// --------------------- READ ME ---------------------
+// Grow then drain: insert n keys, then remove them all. Reports the throughput and the slowest single
+// operation of every phase (a full rehash would show up there), and the heap held at the peak and after
+// the drain (counted by heapCounter.h).
+// Usage: hash_table_drain_bench [--max-size N] [--output FILE]
+
+template<class operationFunction>
+void benchPhase(BenchResults &results, const char *operation, KeyDistribution distribution,
+                const std::vector<int> &keys, operationFunction apply) {
+    double slowest_ns = 0;
+    BenchTimer timer;
+    for (int key: keys) {
+        BenchTimer operation_timer;
+        apply(key);
+        slowest_ns = std::max(slowest_ns, operation_timer.nanoseconds());
+    }
+    int size = (int) keys.size();
+    results.add("hash_table", operation, distributionName(distribution), size, size, timer.nanoseconds());
+    results.addMetric("hash_table", std::string(operation) + "_max_ns", size, slowest_ns);
+}
+
+void benchGrowDrain(BenchResults &results, KeyDistribution distribution, int size) {
+    std::vector<int> keys = makeKeys(distribution, size);
+    long long heap_before = heap_bytes;
+    auto *table = new HashTable<int>;
+    benchPhase(results, "grow_insert", distribution, keys, [table](int key) {
+        table->insert(key, key);
+    });
+    results.addMetric("hash_table", "peak_heap_bytes", size, (double) (heap_bytes - heap_before));
+    results.addMetric("hash_table", "peak_hash_size", size, table->getHashSize());
+
+    benchPhase(results, "drain_remove", distribution, keys, [table](int key) {
+        table->remove(key);
+    });
+    results.addMetric("hash_table", "drained_heap_bytes", size, (double) (heap_bytes - heap_before));
+    results.addMetric("hash_table", "drained_hash_size", size, table->getHashSize());
+    delete table;
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes()) {
+        for (KeyDistribution distribution: {SEQUENTIAL, UNIFORM})
+            benchGrowDrain(results, distribution, size);
+    }
+    results.write(options.output);
+    return 0;
+}
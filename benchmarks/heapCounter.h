@@ -0,0 +1,37 @@
+#ifndef HEAP_COUNTER_H
+#define HEAP_COUNTER_H
+
+// -------------------- LIBRARIES --------------------
+#include <new>
+#include <cstdlib>
+#include <cstddef>
+
+// --------------------- READ ME ---------------------
+// Replaces the global operator new / delete to count the live heap bytes of a benchmark.
+// Include it in one translation unit only (the benchmark main file).
+
+static long long heap_bytes = 0;
+
+// every block keeps its size in front of it
+void *operator new(size_t size) {
+    void *block = malloc(size + sizeof(max_align_t));
+    if (block == nullptr)
+        throw std::bad_alloc();
+    *(size_t *) block = size;
+    heap_bytes += (long long) size;
+    return (char *) block + sizeof(max_align_t);
+}
+
+void operator delete(void *address) noexcept {
+    if (address == nullptr)
+        return;
+    void *block = (char *) address - sizeof(max_align_t);
+    heap_bytes -= (long long) *(size_t *) block;
+    free(block);
+}
+
+void operator delete(void *address, size_t) noexcept {
+    operator delete(address);
+}
+
+#endif /* HEAP_COUNTER_H */
@@ -0,0 +1,126 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+#include <random>
+#include <algorithm>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "heapCounter.h"
+#include "../indexedRankedTree.h"
+
+// --------------------- READ ME ---------------------
+// IndexedTree (hash index to the tree nodes, data stored once) against a HashTable and a ranked Tree
+// kept in sync by hand (data stored twice, an update writes both copies).
+// insert, update (find + change the record), find and remove of every key, plus the heap bytes per entry
+// counted by heapCounter.h. Records are 32 bytes.
+// Usage: indexed_tree_bench [--max-size N] [--output FILE]
+
+struct Record {
+    int score;
+    int payload[7];
+};
+
+// the two structures an application keeps in sync without IndexedTree
+class SyncedTables {
+public:
+    HashTable<Record> table;
+    Tree<int, Record> tree;
+
+    void insert(int key, const Record &record) {
+        if (table.nodeExist(key))
+            return;
+        table.insert(key, record);
+        tree.insert(key, record);
+    }
+
+    void remove(int key) {
+        if (!table.nodeExist(key))
+            return;
+        table.remove(key);
+        tree.remove(key);
+    }
+
+    Record *find(int key) {
+        return table.find(key);
+    }
+
+    void update(int key, int score) {
+        Record *record = table.find(key);
+        if (record == nullptr)
+            return;
+        record->score = score;
+        tree.find(key)->data.score = score;
+    }
+};
+
+class IndexedTable {
+public:
+    IndexedTree<Record> tree;
+
+    void insert(int key, const Record &record) {
+        tree.insert(key, record);
+    }
+
+    void remove(int key) {
+        tree.remove(key);
+    }
+
+    Record *find(int key) {
+        return tree.find(key);
+    }
+
+    void update(int key, int score) {
+        Record *record = tree.find(key);
+        if (record != nullptr)
+            record->score = score;
+    }
+};
+
+template<class tableType>
+void benchTable(BenchResults &results, const char *structure, const std::vector<int> &keys,
+                const std::vector<int> &queries) {
+    int size = (int) keys.size();
+    long long heap_before = heap_bytes;
+    auto *table = new tableType;
+    BenchTimer insert_timer;
+    for (int key: keys)
+        table->insert(key, Record{key, {}});
+    results.add(structure, "insert", "uniform", size, size, insert_timer.nanoseconds());
+    results.addMetric(structure, "bytes_per_entry", size, (double) (heap_bytes - heap_before) / size);
+
+    BenchTimer update_timer;
+    for (int key: queries)
+        table->update(key, -key);
+    results.add(structure, "update", "uniform", size, size, update_timer.nanoseconds());
+
+    long long found = 0;
+    BenchTimer find_timer;
+    for (int key: queries)
+        found += table->find(key)->score;
+    results.add(structure, "find", "uniform", size, size, find_timer.nanoseconds());
+
+    BenchTimer remove_timer;
+    for (int key: queries)
+        table->remove(key);
+    results.add(structure, "remove", "uniform", size, size, remove_timer.nanoseconds());
+    benchKeep(found);
+    delete table;
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes()) {
+        std::vector<int> keys(size);
+        for (int i = 0; i < size; i++)
+            keys[i] = i;
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(BENCH_SEED));
+        std::vector<int> queries(keys);
+        std::shuffle(queries.begin(), queries.end(), std::mt19937(BENCH_SEED + 1));
+        benchTable<SyncedTables>(results, "synced_hash_and_tree", keys, queries);
+        benchTable<IndexedTable>(results, "indexed_tree", keys, queries);
+    }
+    results.write(options.output);
+    return 0;
+}
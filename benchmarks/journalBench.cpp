@@ -0,0 +1,120 @@
+
+// -------------------- LIBRARIES --------------------
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+// ------------------ INCLUDE FILES ------------------
+#include "../journal.h"
+
+// --------------------- DEFINES ---------------------
+#define DEFAULT_NUMBER_OF_OPERATIONS 100000
+#define JOURNAL_PATH "bench_journal.bin"
+#define SNAPSHOT_PATH "bench_journal_snapshot.bin"
+
+// --------------------- READ ME ---------------------
+// Write throughput of a mixed insert / remove / upgradeRank workload on a ranked Tree,
+// without a journal and with a journal at several group commit batch sizes, then a recovery check.
+// Usage: journalBench [number_of_operations]
+
+typedef std::chrono::steady_clock benchClock;
+
+struct Operation {
+    JournalOperation type;
+    int key;
+    int key_2;
+};
+
+static std::vector<Operation> makeOperations(int operations_number) {
+    std::mt19937 generator(234218);
+    std::uniform_int_distribution<int> keys(0, operations_number);
+    std::uniform_int_distribution<int> types(0, 9);
+    std::vector<Operation> operations;
+    for (int i = 0; i < operations_number; i++) {
+        int type = types(generator);
+        int key = keys(generator);
+        if (type < 6)
+            operations.push_back({JOURNAL_INSERT, key, 0});
+        else if (type < 8)
+            operations.push_back({JOURNAL_REMOVE, key, 0});
+        else
+            operations.push_back({JOURNAL_UPGRADE_RANK, key, key + 100});
+    }
+    return operations;
+}
+
+static void apply(Tree<int, int> &tree, const Operation &operation) {
+    if (operation.type == JOURNAL_INSERT)
+        tree.insert(operation.key, operation.key);
+    else if (operation.type == JOURNAL_REMOVE)
+        tree.remove(operation.key);
+    else
+        tree.upgradeRank(operation.key, operation.key_2, 1);
+}
+
+static double runWithoutJournal(const std::vector<Operation> &operations) {
+    Tree<int, int> tree;
+    auto start = benchClock::now();
+    for (const Operation &operation: operations)
+        apply(tree, operation);
+    return std::chrono::duration<double>(benchClock::now() - start).count();
+}
+
+static double runWithJournal(const std::vector<Operation> &operations, int batch_size, Tree<int, int> &tree) {
+    std::remove(JOURNAL_PATH);
+    auto start = benchClock::now();
+    {
+        Journal<int, int> journal(JOURNAL_PATH, batch_size);
+        for (const Operation &operation: operations) {
+            if (operation.type == JOURNAL_INSERT)
+                journal.logInsert(operation.key, operation.key);
+            else if (operation.type == JOURNAL_REMOVE)
+                journal.logRemove(operation.key);
+            else
+                journal.logUpgradeRank(operation.key, operation.key_2, 1);
+            apply(tree, operation);
+        }
+    }
+    return std::chrono::duration<double>(benchClock::now() - start).count();
+}
+
+static bool sameContent(const Tree<int, int> &first, const Tree<int, int> &second) {
+    int size = first.getNodeCounter();
+    if (size != second.getNodeCounter())
+        return false;
+    std::vector<int> first_keys(size), second_keys(size), first_data(size), second_data(size);
+    std::vector<double> first_ranks(size), second_ranks(size);
+    first.exportInorder(first_keys.data(), first_data.data(), first_ranks.data());
+    second.exportInorder(second_keys.data(), second_data.data(), second_ranks.data());
+    return first_keys == second_keys && first_data == second_data && first_ranks == second_ranks;
+}
+
+int main(int argc, char *argv[]) {
+    int operations_number = argc > 1 ? atoi(argv[1]) : DEFAULT_NUMBER_OF_OPERATIONS;
+    std::vector<Operation> operations = makeOperations(operations_number);
+
+    double seconds = runWithoutJournal(operations);
+    std::cout << "no journal:        " << operations_number / seconds / 1e6 << " M ops/s" << std::endl;
+
+    int batch_sizes[] = {1, 16, 256, 4096};
+    for (int batch_size: batch_sizes) {
+        Tree<int, int> tree;
+        seconds = runWithJournal(operations, batch_size, tree);
+        std::cout << "journal batch " << batch_size << ": " << operations_number / seconds / 1e6 << " M ops/s"
+                  << std::endl;
+
+        Tree<int, int> empty;
+        saveSnapshot(empty, SNAPSHOT_PATH);
+        Tree<int, int> recovered;
+        long long replayed = recover(recovered, SNAPSHOT_PATH, JOURNAL_PATH);
+        if (replayed != operations_number || !sameContent(tree, recovered)) {
+            std::cout << "recovery mismatch for batch size " << batch_size << std::endl;
+            return 1;
+        }
+    }
+    std::remove(JOURNAL_PATH);
+    std::remove(SNAPSHOT_PATH);
+    return 0;
+}
@@ -0,0 +1,79 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../AVL_Tree/rankedAVLTree.h"
+#include "../AVL_Tree/persistentRankedTree.h"
+
+// -------------------- DEFINES --------------------
+#define SNAPSHOT_REPEATS 1000
+
+// --------------------- READ ME ---------------------
+// Versioned ranked tree: cost of taking a snapshot (PersistentTree shares the root, Tree needs a deep copy
+// through exportInorder + buildFromSorted) and the insert / upgradeRank / remove cost of path copying
+// against the mutable ranked Tree.
+// Usage: persistent_tree_bench [--max-size N] [--output FILE]
+
+void benchSnapshot(BenchResults &results, int size) {
+    std::vector<int> keys(size);
+    for (int i = 0; i < size; i++)
+        keys[i] = i;
+    PersistentTree<int, int> persistent;
+    persistent.buildFromSorted(keys.data(), keys.data(), nullptr, size);
+    BenchTimer snapshot_timer;
+    for (int i = 0; i < SNAPSHOT_REPEATS; i++) {
+        PersistentTree<int, int> snapshot = persistent.snapshot();
+        benchKeep(snapshot.getNodeCounter());
+    }
+    results.add("persistent_tree", "snapshot", "sequential", size, SNAPSHOT_REPEATS, snapshot_timer.nanoseconds());
+
+    Tree<int, int> tree;
+    tree.buildFromSorted(keys.data(), keys.data(), nullptr, size);
+    int repeats = std::max(1, SNAPSHOT_REPEATS * BENCH_MIN_SIZE / size);
+    std::vector<int> data(size);
+    std::vector<double> ranks(size);
+    BenchTimer copy_timer;
+    for (int i = 0; i < repeats; i++) {
+        tree.exportInorder(keys.data(), data.data(), ranks.data());
+        Tree<int, int> copy;
+        copy.buildFromSorted(keys.data(), data.data(), ranks.data(), size);
+        benchKeep(copy.getNodeCounter());
+    }
+    results.add("ranked_tree", "snapshot_deep_copy", "sequential", size, repeats, copy_timer.nanoseconds());
+}
+
+template<class treeType>
+void benchUpdates(BenchResults &results, const char *structure, KeyDistribution distribution, int size) {
+    std::vector<int> keys = makeKeys(distribution, size, BENCH_SEED);
+    treeType tree;
+    BenchTimer insert_timer;
+    for (int key: keys)
+        tree.insert(key, key);
+    results.add(structure, "insert", distributionName(distribution), size, size, insert_timer.nanoseconds());
+
+    BenchTimer upgrade_timer;
+    for (int key: keys)
+        tree.upgradeRank(key, key + size / 100 + 1, 1);
+    results.add(structure, "upgrade_rank", distributionName(distribution), size, size, upgrade_timer.nanoseconds());
+
+    BenchTimer remove_timer;
+    for (int key: keys)
+        tree.remove(key);
+    results.add(structure, "remove", distributionName(distribution), size, size, remove_timer.nanoseconds());
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes()) {
+        benchSnapshot(results, size);
+        for (KeyDistribution distribution: {SEQUENTIAL, UNIFORM}) {
+            benchUpdates<Tree<int, int>>(results, "ranked_tree", distribution, size);
+            benchUpdates<PersistentTree<int, int>>(results, "persistent_tree", distribution, size);
+        }
+    }
+    results.write(options.output);
+    return 0;
+}
@@ -0,0 +1,54 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+#include <cstdint>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../AVL_Tree/rankedAVLTree.h"
+#include "../AVL_Tree/fixedPoint.h"
+
+// -------------------- DEFINES --------------------
+#define RANGE_FRACTION 100
+
+// --------------------- READ ME ---------------------
+// Ranked Tree with every supported rank type: node size, upgradeRank and getNodeRank throughput.
+// Ranges cover 1 / RANGE_FRACTION of the keys, so every upgradeRank leaves collectors on two paths.
+// Usage: rank_type_bench [--max-size N] [--output FILE]
+
+template<class rankType>
+void benchRankType(BenchResults &results, const char *structure, KeyDistribution distribution, int size) {
+    std::vector<int> keys = makeKeys(distribution, size);
+    Tree<int, int, rankType> tree;
+    for (int key: keys)
+        tree.insert(key, key);
+    results.addMetric(structure, "node_bytes", size, (double) Tree<int, int, rankType>::getNodeBytes());
+
+    BenchTimer upgrade_timer;
+    for (int key: keys)
+        tree.upgradeRank(key, key + size / RANGE_FRACTION + 1, 1);
+    results.add(structure, "upgrade_rank", distributionName(distribution), size, size, upgrade_timer.nanoseconds());
+
+    rankType sum = 0;
+    BenchTimer rank_timer;
+    for (int key: keys)
+        sum += tree.getNodeRank(key);
+    benchKeep(sum);
+    results.add(structure, "get_node_rank", distributionName(distribution), size, size, rank_timer.nanoseconds());
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes()) {
+        for (KeyDistribution distribution: {SEQUENTIAL, UNIFORM}) {
+            benchRankType<double>(results, "ranked_tree_double", distribution, size);
+            benchRankType<int64_t>(results, "ranked_tree_int64", distribution, size);
+            benchRankType<int32_t>(results, "ranked_tree_int32", distribution, size);
+            benchRankType<FixedPoint<16>>(results, "ranked_tree_fixed_16_int64", distribution, size);
+            benchRankType<FixedPoint<8, int32_t>>(results, "ranked_tree_fixed_8_int32", distribution, size);
+        }
+    }
+    results.write(options.output);
+    return 0;
+}
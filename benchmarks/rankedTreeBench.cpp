@@ -0,0 +1,96 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+#include <random>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../hashTable.h"
+
+// --------------------- DEFINES ---------------------
+#define RANK_RANGE_WIDTH 1000
+static_assert(RANK_RANGE_WIDTH <= BENCH_KEY_HEADROOM, "key + RANK_RANGE_WIDTH must not overflow");
+
+// --------------------- READ ME ---------------------
+// Benchmarks of the ranked Tree (insert, find, upgradeRank, getNodeRank, remove)
+// and of the HashTable (insert, lookup, resize) over every size and distribution, plus colliding keys.
+// "resize" is the longest single insert of the run, that is the pause of the biggest rehash.
+// Usage: ranked_tree_bench [--max-size N] [--output FILE]
+
+void benchRankedTree(BenchResults &results, KeyDistribution distribution, int size) {
+    const char *name = distributionName(distribution);
+    std::vector<int> keys = makeKeys(distribution, size);
+    std::vector<int> queries = makeKeys(distribution, size, BENCH_SEED + 1);
+    Tree<int, int> tree;
+
+    BenchTimer insert_timer;
+    for (int key: keys)
+        tree.insert(key, key);
+    results.add("ranked_tree", "insert", name, size, size, insert_timer.nanoseconds());
+
+    BenchTimer find_timer;
+    int found = 0;
+    for (int key: queries)
+        found += tree.find(key) != nullptr;
+    benchKeep(found);
+    results.add("ranked_tree", "find", name, size, size, find_timer.nanoseconds());
+
+    BenchTimer upgrade_timer;
+    for (int key: queries)
+        tree.upgradeRank(key, key + RANK_RANGE_WIDTH, 1);
+    results.add("ranked_tree", "upgradeRank", name, size, size, upgrade_timer.nanoseconds());
+
+    BenchTimer rank_timer;
+    double ranks = 0;
+    for (int key: queries)
+        ranks += tree.getNodeRank(tree.getRoot(), key);
+    benchKeep(ranks);
+    results.add("ranked_tree", "getNodeRank", name, size, size, rank_timer.nanoseconds());
+
+    BenchTimer remove_timer;
+    for (int key: keys)
+        tree.remove(key);
+    results.add("ranked_tree", "remove", name, size, size, remove_timer.nanoseconds());
+}
+
+void benchHashTable(BenchResults &results, const char *name, const std::vector<int> &keys,
+                    const std::vector<int> &queries) {
+    int size = (int) keys.size();
+    HashTable<int> table;
+
+    double longest_insert = 0;
+    BenchTimer insert_timer;
+    for (int key: keys) {
+        BenchTimer single_insert_timer;
+        table.insert(key, key);
+        longest_insert = std::max(longest_insert, single_insert_timer.nanoseconds());
+    }
+    results.add("hash_table", "insert", name, size, size, insert_timer.nanoseconds());
+    results.add("hash_table", "resize", name, size, 1, longest_insert);
+
+    BenchTimer lookup_timer;
+    long long sum = 0;
+    for (int key: queries) {
+        if (table.nodeExist(key))
+            sum += table.getData(key);
+    }
+    benchKeep(sum);
+    results.add("hash_table", "lookup", name, size, size, lookup_timer.nanoseconds());
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes()) {
+        for (KeyDistribution distribution: ALL_DISTRIBUTIONS) {
+            benchRankedTree(results, distribution, size);
+            benchHashTable(results, distributionName(distribution), makeKeys(distribution, size),
+                           makeKeys(distribution, size, BENCH_SEED + 1));
+        }
+        int hash_size = HashTable<int>::hashSizeFor(size);
+        benchHashTable(results, "colliding", makeCollidingKeys(size, hash_size),
+                       makeCollidingKeys(size, hash_size, BENCH_SEED + 1));
+    }
+    results.write(options.output);
+    return 0;
+}
@@ -0,0 +1,52 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../AVL_Tree/rankedAVLTree.h"
+
+// --------------------- READ ME ---------------------
+// Expiring a key range: removeRange against one remove per key, on a tree of the keys [0, n) with
+// pending collectors. The range of "removed" keys starts in the middle of the tree.
+// Usage: remove_range_bench [--max-size N] [--output FILE]
+
+static void buildTree(int size, Tree<int, int> &tree) {
+    std::vector<int> keys(size);
+    for (int i = 0; i < size; i++)
+        keys[i] = i;
+    tree.buildFromSorted(keys.data(), keys.data(), nullptr, size);
+    tree.upgradeRank(size / 4, size, 1); // leaves pending collectors around the range
+}
+
+void benchRemoveRange(BenchResults &results, int size, int removed) {
+    int lo = size / 3;
+    Tree<int, int> tree;
+    buildTree(size, tree);
+    BenchTimer range_timer;
+    int range_removed = tree.removeRange(lo, lo + removed);
+    results.add("ranked_tree", "remove_range", "sequential", size, removed, range_timer.nanoseconds());
+    if (range_removed != removed || tree.getNodeCounter() != size - removed ||
+        tree.getNodeRank(size - 1) != 1 || tree.getNodeRank(0) != 0) {
+        std::cerr << "removeRange removed the wrong keys" << std::endl;
+        exit(1);
+    }
+
+    buildTree(size, tree);
+    BenchTimer one_by_one_timer;
+    for (int key = lo; key < lo + removed; key++)
+        tree.remove(key);
+    results.add("ranked_tree", "remove_one_by_one", "sequential", size, removed, one_by_one_timer.nanoseconds());
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes()) {
+        for (int removed = BENCH_MIN_SIZE / 10; removed <= size / 2; removed *= 10)
+            benchRemoveRange(results, size, removed);
+        benchRemoveRange(results, size, size / 2);
+    }
+    results.write(options.output);
+    return 0;
+}
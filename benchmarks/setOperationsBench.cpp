@@ -0,0 +1,68 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+#include <string>
+#include <thread>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../AVL_Tree/parallelSetOperations.h"
+
+// --------------------- READ ME ---------------------
+// Merging a daily delta (n / 10 uniform keys) into a main index of n uniform keys:
+// n / 10 single inserts against unite, and intersect / subtract, on 1, 2, 4, ... up to the core count threads.
+// Usage: set_operations_bench [--max-size N] [--output FILE]
+
+static void buildTree(Tree<int, int> &tree, std::vector<int> keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    tree.buildFromSorted(keys.data(), keys.data(), nullptr, (int) keys.size());
+}
+
+void benchSetOperations(BenchResults &results, int size, const std::vector<int> &threads_counts) {
+    std::vector<int> main_keys = makeKeys(UNIFORM, size);
+    std::vector<int> delta_keys = makeKeys(UNIFORM, size / 10, BENCH_SEED + 1);
+    // half of the delta updates keys already in the main index
+    for (size_t i = 0; i < delta_keys.size(); i += 2)
+        delta_keys[i] = main_keys[i];
+
+    Tree<int, int> main_index;
+    buildTree(main_index, main_keys);
+    BenchTimer insert_timer;
+    for (int key: delta_keys)
+        main_index.insert(key, key);
+    results.add("ranked_tree", "merge_inserts_1_thread", "uniform", size, (long long) delta_keys.size(),
+                insert_timer.nanoseconds());
+
+    const char *names[] = {"unite", "intersect", "subtract"};
+    for (int operation = 0; operation < 3; operation++) {
+        for (int threads: threads_counts) {
+            Tree<int, int> first, second;
+            buildTree(first, main_keys);
+            buildTree(second, delta_keys);
+            BenchTimer timer;
+            if (operation == 0)
+                parallelUnite(first, second, threads);
+            else if (operation == 1)
+                parallelIntersect(first, second, threads);
+            else
+                parallelSubtract(first, second, threads);
+            std::string name = std::string(names[operation]) + "_" + std::to_string(threads) + "_threads";
+            results.add("ranked_tree", name, "uniform", size, (long long) delta_keys.size(), timer.nanoseconds());
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    int cores = (int) std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> threads_counts;
+    for (int threads = 1; threads < cores; threads *= 2)
+        threads_counts.push_back(threads);
+    threads_counts.push_back(cores);
+    for (int size: options.sizes())
+        benchSetOperations(results, size, threads_counts);
+    results.write(options.output);
+    return 0;
+}
@@ -0,0 +1,70 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+#include <mutex>
+#include <thread>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../shardedHashTable.h"
+
+// -------------------- DEFINES --------------------
+#define MAX_BENCH_THREADS 16
+
+// --------------------- READ ME ---------------------
+// Insert throughput by thread count: one HashTable behind one mutex against a ShardedHashTable
+// (one lock per shard, one shard per hardware thread), every thread inserting its own slice of the keys.
+// insertBulk of the same keys is timed as well.
+// Usage: sharded_hash_table_bench [--max-size N] [--output FILE]
+
+template<class insertFunction>
+double timeThreads(const std::vector<int> &keys, int threads, insertFunction insert) {
+    BenchTimer timer;
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < threads; thread++) {
+        workers.emplace_back([&keys, thread, threads, &insert]() {
+            for (size_t i = thread; i < keys.size(); i += threads)
+                insert(keys[i]);
+        });
+    }
+    for (std::thread &worker: workers)
+        worker.join();
+    return timer.nanoseconds();
+}
+
+void benchThreads(BenchResults &results, int size, int threads) {
+    std::vector<int> keys = makeKeys(UNIFORM, size);
+    std::string operation = "insert_threads_" + std::to_string(threads);
+
+    HashTable<int> table;
+    std::mutex table_lock;
+    double single_ns = timeThreads(keys, threads, [&table, &table_lock](int key) {
+        std::lock_guard<std::mutex> guard(table_lock);
+        table.insert(key, key);
+    });
+    results.add("hash_table_locked", operation, "uniform", size, size, single_ns);
+
+    ShardedHashTable<int> sharded;
+    double sharded_ns = timeThreads(keys, threads, [&sharded](int key) {
+        sharded.insert(key, key);
+    });
+    results.add("sharded_hash_table", operation, "uniform", size, size, sharded_ns);
+
+    ShardedHashTable<int> bulk;
+    BenchTimer bulk_timer;
+    bulk.insertBulk(keys.data(), keys.data(), size, threads);
+    results.add("sharded_hash_table", "insert_bulk_threads_" + std::to_string(threads), "uniform", size, size,
+                bulk_timer.nanoseconds());
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    int max_threads = (int) std::min(MAX_BENCH_THREADS, (int) std::max(1u, std::thread::hardware_concurrency()));
+    for (int size: options.sizes()) {
+        for (int threads = 1; threads <= max_threads; threads *= 2)
+            benchThreads(results, size, threads);
+    }
+    results.write(options.output);
+    return 0;
+}
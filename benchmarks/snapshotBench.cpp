@@ -0,0 +1,114 @@
+
+// -------------------- LIBRARIES --------------------
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+// ------------------ INCLUDE FILES ------------------
+#include "../snapshot.h"
+
+// --------------------- DEFINES ---------------------
+#define DEFAULT_NUMBER_OF_NODES 1000000
+#define TREE_SNAPSHOT_PATH "tree_snapshot.bin"
+#define HASH_SNAPSHOT_PATH "hash_snapshot.bin"
+
+// --------------------- READ ME ---------------------
+// Startup time: rebuilding a Tree / HashTable by replaying inserts against loading a snapshot of it.
+// Usage: snapshotBench [number_of_nodes]
+
+typedef std::chrono::steady_clock benchClock;
+
+static double secondsSince(benchClock::time_point start) {
+    return std::chrono::duration<double>(benchClock::now() - start).count();
+}
+
+static void report(const char *name, int nodes, double seconds) {
+    std::cout << name << ": " << seconds * 1000 << " ms (" << nodes / seconds / 1e6 << " M nodes/s)" << std::endl;
+}
+
+void benchTree(const std::vector<int> &keys) {
+    int nodes = (int) keys.size();
+    Tree<int, int> source;
+    for (int key: keys)
+        source.insert(key, key * 2);
+    saveSnapshot(source, TREE_SNAPSHOT_PATH);
+
+    auto start = benchClock::now();
+    Tree<int, int> replayed;
+    for (int key: keys)
+        replayed.insert(key, key * 2);
+    report("tree replay inserts", nodes, secondsSince(start));
+
+    start = benchClock::now();
+    Tree<int, int> loaded;
+    loadSnapshot(loaded, TREE_SNAPSHOT_PATH);
+    report("tree snapshot load ", nodes, secondsSince(start));
+
+    start = benchClock::now();
+    TreeSnapshotView<int, int> view(TREE_SNAPSHOT_PATH);
+    report("tree snapshot view ", nodes, secondsSince(start));
+
+    long long checksum = 0;
+    for (int key: keys) {
+        const int *data = view.find(key);
+        if (data == nullptr || loaded.find(key) == nullptr || loaded.find(key)->data != *data) {
+            std::cout << "tree snapshot mismatch on key " << key << std::endl;
+            exit(1);
+        }
+        checksum += *data;
+    }
+    std::cout << "tree checksum: " << checksum << std::endl;
+}
+
+void benchHashTable(const std::vector<int> &keys) {
+    int nodes = (int) keys.size();
+    {
+        HashTable<int> source;
+        for (int key: keys)
+            source.insert(key, key * 2);
+        saveSnapshot(source, HASH_SNAPSHOT_PATH);
+    }
+
+    auto start = benchClock::now();
+    HashTable<int> replayed;
+    for (int key: keys)
+        replayed.insert(key, key * 2);
+    report("hash replay inserts", nodes, secondsSince(start));
+
+    start = benchClock::now();
+    HashTable<int> loaded;
+    loadSnapshot(loaded, HASH_SNAPSHOT_PATH);
+    report("hash snapshot load ", nodes, secondsSince(start));
+
+    start = benchClock::now();
+    HashTableSnapshotView<int> view(HASH_SNAPSHOT_PATH);
+    report("hash snapshot view ", nodes, secondsSince(start));
+
+    long long checksum = 0;
+    for (int key: keys) {
+        const int *data = view.find(key);
+        if (data == nullptr || !loaded.nodeExist(key) || loaded.getData(key) != *data) {
+            std::cout << "hash snapshot mismatch on key " << key << std::endl;
+            exit(1);
+        }
+        checksum += *data;
+    }
+    std::cout << "hash checksum: " << checksum << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    int nodes = argc > 1 ? atoi(argv[1]) : DEFAULT_NUMBER_OF_NODES;
+    std::vector<int> keys(nodes);
+    for (int i = 0; i < nodes; i++)
+        keys[i] = i * 3 - nodes;
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(234218));
+
+    benchTree(keys);
+    benchHashTable(keys);
+    std::remove(TREE_SNAPSHOT_PATH);
+    std::remove(HASH_SNAPSHOT_PATH);
+    return 0;
+}
@@ -0,0 +1,62 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../AVL_Tree/rankedAVLTree.h"
+
+// --------------------- READ ME ---------------------
+// Resharding: two shards hold the key ranges [0, n) and [n, 2n), the top "moved" keys of the first shard
+// move to the second one. Compares split + join against removing and inserting the keys one by one.
+// Usage: split_join_bench [--max-size N] [--output FILE]
+
+static void buildShards(int size, Tree<int, int> &low_shard, Tree<int, int> &high_shard) {
+    std::vector<int> low_keys(size), high_keys(size);
+    for (int i = 0; i < size; i++) {
+        low_keys[i] = i;
+        high_keys[i] = size + i;
+    }
+    low_shard.buildFromSorted(low_keys.data(), low_keys.data(), nullptr, size);
+    high_shard.buildFromSorted(high_keys.data(), high_keys.data(), nullptr, size);
+    low_shard.upgradeRank(0, 2 * size, 1); // leaves pending collectors to carry over
+}
+
+void benchMove(BenchResults &results, int size, int moved) {
+    Tree<int, int> low_shard, high_shard;
+    buildShards(size, low_shard, high_shard);
+    BenchTimer split_join_timer;
+    Tree<int, int> moved_keys = low_shard.split(size - moved);
+    moved_keys.join(high_shard);
+    high_shard = std::move(moved_keys);
+    results.add("ranked_tree", "move_range_split_join", "sequential", size, moved, split_join_timer.nanoseconds());
+    if (low_shard.getNodeCounter() != size - moved || high_shard.getNodeCounter() != size + moved ||
+        high_shard.getNodeRank(size - 1) != 1) {
+        std::cerr << "split / join moved the wrong keys" << std::endl;
+        exit(1);
+    }
+
+    buildShards(size, low_shard, high_shard);
+    BenchTimer one_by_one_timer;
+    for (int key = size - moved; key < size; key++) {
+        auto node = low_shard.find(key);
+        int data = node->data;
+        double rank = low_shard.getNodeRank(key);
+        low_shard.remove(key);
+        high_shard.insert(key, data);
+        high_shard.upgradeRank(key, key + 1, rank);
+    }
+    results.add("ranked_tree", "move_range_one_by_one", "sequential", size, moved, one_by_one_timer.nanoseconds());
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes()) {
+        for (int moved = BENCH_MIN_SIZE; moved <= size / 2; moved *= 10)
+            benchMove(results, size, moved);
+        benchMove(results, size, size / 2);
+    }
+    results.write(options.output);
+    return 0;
+}
@@ -0,0 +1,53 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../hashTable.h"
+
+// --------------------- READ ME ---------------------
+// Runs the same ranked Tree and HashTable workload with the counters compiled in (stats_bench)
+// and compiled out (stats_bench_off), so the two timings show the counters overhead.
+// With AVL_STATS_ON the collected stats are dumped as JSON after the timings.
+// Usage: stats_bench [--max-size N] [--output FILE]
+
+void runWorkload(BenchResults &results, int size, Tree<int, int> &tree, HashTable<int> &table) {
+    std::vector<int> keys = makeKeys(UNIFORM, size);
+    std::vector<int> queries = makeKeys(UNIFORM, size, BENCH_SEED + 1);
+#ifdef AVL_STATS_ON
+    const char *structure = "stats_on";
+#else
+    const char *structure = "stats_off";
+#endif
+
+    BenchTimer timer;
+    for (int key: keys) {
+        tree.insert(key, key);
+        table.insert(key, key);
+    }
+    long long found = 0;
+    for (int key: queries)
+        found += (tree.find(key) != nullptr) + table.nodeExist(key);
+    for (int i = 0; i < size; i += 2)
+        tree.remove(keys[i]);
+    benchKeep(found);
+    results.add(structure, "mixed", "uniform", size, 4LL * size, timer.nanoseconds());
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    Tree<int, int> tree;
+    HashTable<int> table;
+    runWorkload(results, (int) options.max_size, tree, table);
+    results.write(options.output);
+#ifdef AVL_STATS_ON
+    std::cout << "{\"tree\": ";
+    tree.dumpStats(std::cout);
+    std::cout << ", \"hash_table\": ";
+    table.dumpStats(std::cout);
+    std::cout << "}" << std::endl;
+#endif /* AVL_STATS_ON */
+    return 0;
+}
@@ -0,0 +1,70 @@
+
+// -------------------- LIBRARIES --------------------
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <functional>
+
+// ------------------ INCLUDE FILES ------------------
+#include "benchUtils.h"
+#include "../AVL_Tree/rankedAVLTree.h"
+
+// --------------------- READ ME ---------------------
+// Leaderboard query: the k highest ranks of a ranked Tree with random ranks and pending upgradeRank collectors.
+// topK (best first search on the max rank augmentation) against a full scan, which resolves every rank with
+// exportInorder and takes the k highest with std::partial_sort. Run with --max-size 10000000 for n = 10M.
+// Usage: top_k_bench [--max-size N] [--output FILE]
+
+#define TOP_K_QUERIES 100
+
+void benchTopK(BenchResults &results, int size) {
+    std::vector<int> keys(size), data(size);
+    std::vector<double> ranks(size);
+    std::mt19937 generator(BENCH_SEED);
+    std::uniform_int_distribution<int> random_ranks(0, 1 << 20);
+    for (int i = 0; i < size; i++) {
+        keys[i] = i;
+        data[i] = i;
+        ranks[i] = random_ranks(generator);
+    }
+    Tree<int, int, double, AVLBalance, MaxRankAugment> tree;
+    tree.buildFromSorted(keys.data(), data.data(), ranks.data(), size);
+    for (int i = 0; i < TOP_K_QUERIES; i++) {
+        int first = (int) (generator() % size);
+        tree.upgradeRank(first, first + size / 10, 1 << 10);
+    }
+
+    for (int k = 10; k <= 1000 && k <= size; k *= 10) {
+        std::vector<int> top_keys(k), top_data(k);
+        std::vector<double> top_ranks(k);
+        BenchTimer top_k_timer;
+        for (int i = 0; i < TOP_K_QUERIES; i++)
+            tree.topK(k, top_keys.data(), top_data.data(), top_ranks.data());
+        results.add("ranked_tree", "top_" + std::to_string(k), "uniform", size, TOP_K_QUERIES,
+                    top_k_timer.nanoseconds());
+
+        BenchTimer scan_timer;
+        tree.exportInorder(keys.data(), data.data(), ranks.data());
+        std::vector<std::pair<double, int>> by_rank(size);
+        for (int i = 0; i < size; i++)
+            by_rank[i] = std::make_pair(ranks[i], keys[i]);
+        std::partial_sort(by_rank.begin(), by_rank.begin() + k, by_rank.end(), std::greater<std::pair<double, int>>());
+        results.add("full_scan", "top_" + std::to_string(k), "uniform", size, 1, scan_timer.nanoseconds());
+
+        for (int i = 0; i < k; i++) {
+            if (top_ranks[i] != by_rank[i].first) {
+                std::cerr << "topK differs from the full scan" << std::endl;
+                exit(1);
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options(argc, argv);
+    BenchResults results;
+    for (int size: options.sizes())
+        benchTopK(results, size);
+    results.write(options.output);
+    return 0;
+}
@@ -0,0 +1,374 @@
+#ifndef BULK_LOADER_H
+#define BULK_LOADER_H
+
+// -------------------- LIBRARIES --------------------
+#include <cstring>
+#include <climits>
+#include <charconv>
+#include <exception>
+#include <cstdint>
+#include <future>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+// ------------------ INCLUDE FILES ------------------
+#include "snapshot.h"
+
+// --------------------- READ ME ---------------------
+// Bulk loading of a HashTable / ranked Tree from a file of (key, data) records, instead of one insert per record.
+// The file is mapped (MappedFile, read sequentially) and split into "threads" chunks at record / line borders,
+// every chunk is parsed on its own thread into its own record array (one copy of the records in all), and the
+// mapping is released before the build. The builds then work on those arrays, nothing is parsed twice.
+// Formats: LOADER_CSV - one "key,data" line per record (\r\n line ends and empty lines are accepted),
+// LOADER_BINARY - packed records of an int key followed by the data bytes, without padding.
+// A key repeated in the file keeps its first record, as if the records were inserted in file order.
+// bulkLoad (Tree) - input in strictly ascending key order is built in O(n) straight from the chunk arrays, every
+// array is freed once the build passed it. Any other input gets its chunks sorted in parallel (O(n / threads
+// log n)), and the build takes the records from a merge of the sorted chunks (run twice, to count the keys first).
+// Loaded nodes get a rank of 0.
+// bulkLoad (HashTable) - the table is built at the hash size it would grow to for the records: the chunks count
+// and scatter their records to the buckets in parallel (a second copy of the records, the chunk arrays are freed
+// as they are scattered), the buckets are sorted in parallel and the table is built from them, without a rehash.
+// Both replace the whole content of the structure, a malformed or truncated file throws loaderError before the
+// structure is touched.
+
+// ----------------- LOADER EXCEPTION -----------------
+class loaderError : public std::exception {
+public:
+    const char *what() const noexcept override {
+        return "Loader error";
+    }
+};
+
+enum LoaderFormat {
+    LOADER_CSV,
+    LOADER_BINARY
+};
+
+// ------------------- RECORD PARSING -------------------
+// reads the record at "position" into "key" and "data" and returns the position after it, or nullptr when only
+// empty lines are left before "end". Throws loaderError on a malformed record.
+template<class dataType>
+const char *readCsvRecord(const char *position, const char *end, int &key, dataType &data) {
+    static_assert(std::is_arithmetic<dataType>::value, "csv data must be a number");
+    while (position < end && (*position == '\n' || (*position == '\r' && position + 1 < end && position[1] == '\n')))
+        position += *position == '\n' ? 1 : 2; // empty line
+    if (position == end)
+        return nullptr;
+    auto key_result = std::from_chars(position, end, key);
+    if (key_result.ec != std::errc() || key_result.ptr == end || *key_result.ptr != ',')
+        throw loaderError();
+    auto data_result = std::from_chars(key_result.ptr + 1, end, data);
+    if (data_result.ec != std::errc())
+        throw loaderError();
+    position = data_result.ptr;
+    if (position < end && *position == '\r')
+        position++;
+    if (position < end && *position++ != '\n')
+        throw loaderError();
+    return position;
+}
+
+template<class dataType>
+const char *readBinaryRecord(const char *position, const char *end, int &key, dataType &data) {
+    if (position == end)
+        return nullptr;
+    memcpy(&key, position, sizeof(int));
+    memcpy(&data, position + sizeof(int), sizeof(dataType));
+    return position + sizeof(int) + sizeof(dataType);
+}
+
+// ------------------- LOADER FILE -------------------
+template<class dataType>
+struct LoadedRecord {
+    int key;
+    dataType data;
+};
+
+// runs "task(i)" for every i < "tasks", each on its own thread (the first one on the calling thread)
+template<class taskFunction>
+void runLoaderTasks(int tasks, taskFunction task) {
+    std::vector<std::future<void>> workers;
+    for (int i = 1; i < tasks; i++)
+        workers.push_back(std::async(std::launch::async, task, i));
+    std::exception_ptr error;
+    try {
+        if (tasks > 0)
+            task(0);
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    for (auto &worker: workers) {
+        try {
+            worker.get(); // rethrows the error of its task
+        }
+        catch (...) {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+// the records of a file, parsed in parallel into one array per chunk, in file order
+template<class dataType>
+class LoaderFile {
+private:
+    std::vector<std::vector<LoadedRecord<dataType>>> chunks;
+    std::vector<bool> chunk_sorted;
+    long long records_number;
+    bool sorted;
+
+    static const char *readRecord(LoaderFormat format, const char *position, const char *end, int &key,
+                                  dataType &data) {
+        if (format == LOADER_CSV)
+            return readCsvRecord(position, end, key, data);
+        return readBinaryRecord(position, end, key, data);
+    }
+
+    void parseChunk(LoaderFormat format, const char *begin, const char *end, int chunk) {
+        std::vector<LoadedRecord<dataType>> &records = chunks[chunk];
+        if (format == LOADER_BINARY)
+            records.reserve((end - begin) / (sizeof(int) + sizeof(dataType)));
+        bool ascending = true;
+        LoadedRecord<dataType> record;
+        const char *position = begin;
+        while ((position = readRecord(format, position, end, record.key, record.data)) != nullptr) {
+            if (!records.empty() && records.back().key >= record.key)
+                ascending = false;
+            records.push_back(record);
+        }
+        chunk_sorted[chunk] = ascending;
+    }
+
+public:
+    LoaderFile(const char *path, LoaderFormat format, int threads) : records_number(0), sorted(true) {
+        static_assert(std::is_trivially_copyable<dataType>::value, "loaded data must be trivially copyable");
+        const size_t record_bytes = sizeof(int) + sizeof(dataType);
+        try {
+            MappedFile mapped(path, 0);
+            const char *begin = mapped.begin();
+            size_t size = mapped.size();
+            if (format == LOADER_BINARY && size % record_bytes != 0)
+                throw loaderError(); // a truncated last record
+            threads = (int) std::max<size_t>(1, std::min<size_t>(std::max(threads, 1), size / record_bytes + 1));
+
+            // chunk i is [borders[i], borders[i + 1]), cut at record / line borders
+            std::vector<const char *> borders(threads + 1, begin + size);
+            borders[0] = begin;
+            for (int i = 1; i < threads; i++) {
+                size_t border = size / threads * i;
+                if (format == LOADER_BINARY)
+                    border -= border % record_bytes;
+                else {
+                    const char *line_end = (const char *) memchr(begin + border, '\n', size - border);
+                    border = line_end == nullptr ? size : line_end + 1 - begin;
+                }
+                borders[i] = std::max(borders[i - 1], begin + border);
+            }
+            chunks.resize(threads);
+            chunk_sorted.assign(threads, true);
+            runLoaderTasks(threads, [&](int chunk) {
+                parseChunk(format, borders[chunk], borders[chunk + 1], chunk);
+            });
+        } catch (const snapshotError &) {
+            throw loaderError(); // no such file
+        }
+
+        const LoadedRecord<dataType> *last = nullptr;
+        for (int chunk = 0; chunk < (int) chunks.size(); chunk++) {
+            if (chunks[chunk].empty())
+                continue;
+            if (!chunk_sorted[chunk] || (last != nullptr && last->key >= chunks[chunk].front().key))
+                sorted = false;
+            last = &chunks[chunk].back();
+            records_number += (long long) chunks[chunk].size();
+        }
+        if (records_number > INT_MAX)
+            throw loaderError();
+    }
+
+    LoaderFile(const LoaderFile &other) = delete;
+
+    LoaderFile &operator=(const LoaderFile &other) = delete;
+
+    std::vector<std::vector<LoadedRecord<dataType>>> &getChunks() {
+        return chunks;
+    }
+
+    int getRecordsNumber() const {
+        return (int) records_number;
+    }
+
+    // true when the keys are strictly ascending in file order
+    bool isSorted() const {
+        return sorted;
+    }
+};
+
+// the records of sorted chunks in ascending key order, a key repeated in several chunks once, from the first
+// chunk that holds it (the first one in the file). Linear in the records times the chunks number.
+template<class dataType>
+class LoaderMerge {
+private:
+    const std::vector<std::vector<LoadedRecord<dataType>>> &chunks;
+    std::vector<size_t> positions;
+
+public:
+    explicit LoaderMerge(const std::vector<std::vector<LoadedRecord<dataType>>> &chunks) :
+            chunks(chunks), positions(chunks.size(), 0) {}
+
+    // false when every chunk was merged
+    bool next(int &key, dataType &data) {
+        int smallest = -1;
+        for (int chunk = 0; chunk < (int) chunks.size(); chunk++) {
+            if (positions[chunk] < chunks[chunk].size() &&
+                (smallest < 0 || chunks[chunk][positions[chunk]].key <
+                                 chunks[smallest][positions[smallest]].key))
+                smallest = chunk;
+        }
+        if (smallest < 0)
+            return false;
+        key = chunks[smallest][positions[smallest]].key;
+        data = chunks[smallest][positions[smallest]].data;
+        for (int chunk = 0; chunk < (int) chunks.size(); chunk++) {
+            if (positions[chunk] < chunks[chunk].size() && chunks[chunk][positions[chunk]].key == key)
+                positions[chunk]++;
+        }
+        return true;
+    }
+};
+
+// ----------------- BULK LOAD (TREE) -----------------
+template<class dataType, class rankType, class balancePolicy, class augmentPolicy, class storagePolicy>
+void bulkLoad(Tree<int, dataType, rankType, balancePolicy, augmentPolicy, storagePolicy> &tree, const char *path,
+              LoaderFormat format, int threads = 1) {
+    LoaderFile<dataType> file(path, format, threads);
+    auto &chunks = file.getChunks();
+    if (file.isSorted()) {
+        size_t chunk = 0, position = 0;
+        tree.buildFromSorted(file.getRecordsNumber(), [&](int &key, dataType &data) {
+            while (position == chunks[chunk].size()) {
+                std::vector<LoadedRecord<dataType>>().swap(chunks[chunk]); // passed, freed
+                chunk++;
+                position = 0;
+            }
+            key = chunks[chunk][position].key;
+            data = chunks[chunk][position].data;
+            position++;
+        });
+        return;
+    }
+
+    // every chunk sorted on its own thread, the stable sort keeps the first record of a repeated key first
+    runLoaderTasks((int) chunks.size(), [&](int chunk) {
+        auto &records = chunks[chunk];
+        std::stable_sort(records.begin(), records.end(), [](const LoadedRecord<dataType> &a,
+                                                            const LoadedRecord<dataType> &b) {
+            return a.key < b.key;
+        });
+        records.erase(std::unique(records.begin(), records.end(), [](const LoadedRecord<dataType> &a,
+                                                                     const LoadedRecord<dataType> &b) {
+            return a.key == b.key;
+        }), records.end());
+    });
+    int keys_number = 0;
+    int key;
+    dataType data;
+    LoaderMerge<dataType> counter(chunks);
+    while (counter.next(key, data))
+        keys_number++;
+    LoaderMerge<dataType> merge(chunks);
+    tree.buildFromSorted(keys_number, [&merge](int &key, dataType &data) {
+        merge.next(key, data);
+    });
+}
+
+// -------------- BULK LOAD (HASH TABLE) --------------
+template<class dataType>
+void bulkLoad(HashTable<dataType> &table, const char *path, LoaderFormat format, int threads = 1) {
+    LoaderFile<dataType> file(path, format, threads);
+    auto &chunks = file.getChunks();
+    int chunks_number = (int) chunks.size();
+    int size = file.getRecordsNumber();
+    int hash_size = HashTable<dataType>::hashSizeFor(size); // repeated keys only lower the final load factor
+
+    // bucket counts per chunk, then every (bucket, chunk) gets its range: file order inside every bucket
+    std::vector<std::vector<int>> chunk_counts(chunks_number);
+    runLoaderTasks(chunks_number, [&](int chunk) {
+        chunk_counts[chunk].assign(hash_size, 0);
+        for (const auto &record: chunks[chunk])
+            chunk_counts[chunk][HashTable<dataType>::hashFunction(record.key, hash_size)]++;
+    });
+    std::vector<uint64_t> bucket_offsets(hash_size + 1, 0);
+    uint64_t offset = 0;
+    for (int bucket = 0; bucket < hash_size; bucket++) {
+        bucket_offsets[bucket] = offset;
+        for (int chunk = 0; chunk < chunks_number; chunk++) {
+            int count = chunk_counts[chunk][bucket];
+            chunk_counts[chunk][bucket] = (int) offset; // now the next position of the chunk in the bucket
+            offset += count;
+        }
+    }
+    bucket_offsets[hash_size] = offset;
+
+    std::vector<int> keys(size);
+    std::vector<dataType> data(size);
+    runLoaderTasks(chunks_number, [&](int chunk) {
+        std::vector<int> &next_position = chunk_counts[chunk];
+        for (const auto &record: chunks[chunk]) {
+            int position = next_position[HashTable<dataType>::hashFunction(record.key, hash_size)]++;
+            keys[position] = record.key;
+            data[position] = record.data;
+        }
+        std::vector<LoadedRecord<dataType>>().swap(chunks[chunk]);
+        std::vector<int>().swap(next_position);
+    });
+
+    // every bucket sorted by key with its repeated keys dropped (stable, the first record stays), in parallel
+    // over ranges of buckets, then the buckets are packed down over the dropped records
+    std::vector<int> bucket_sizes(hash_size);
+    runLoaderTasks(chunks_number, [&](int task) {
+        std::vector<int> order;
+        std::vector<int> bucket_keys;
+        std::vector<dataType> bucket_data;
+        for (int bucket = task; bucket < hash_size; bucket += chunks_number) {
+            int first = (int) bucket_offsets[bucket];
+            int bucket_size = (int) (bucket_offsets[bucket + 1] - bucket_offsets[bucket]);
+            order.resize(bucket_size);
+            for (int i = 0; i < bucket_size; i++)
+                order[i] = first + i;
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+                return keys[a] < keys[b];
+            });
+            bucket_keys.clear();
+            bucket_data.clear();
+            for (int record: order) {
+                if (!bucket_keys.empty() && bucket_keys.back() == keys[record])
+                    continue;
+                bucket_keys.push_back(keys[record]);
+                bucket_data.push_back(data[record]);
+            }
+            std::copy(bucket_keys.begin(), bucket_keys.end(), keys.begin() + first);
+            std::copy(bucket_data.begin(), bucket_data.end(), data.begin() + first);
+            bucket_sizes[bucket] = (int) bucket_keys.size();
+        }
+    });
+    offset = 0;
+    for (int bucket = 0; bucket < hash_size; bucket++) {
+        uint64_t first = bucket_offsets[bucket];
+        if (offset != first) {
+            std::copy(keys.begin() + first, keys.begin() + first + bucket_sizes[bucket], keys.begin() + offset);
+            std::copy(data.begin() + first, data.begin() + first + bucket_sizes[bucket], data.begin() + offset);
+        }
+        bucket_offsets[bucket] = offset;
+        offset += bucket_sizes[bucket];
+    }
+    bucket_offsets[hash_size] = offset;
+    table.buildFromSorted(hash_size, bucket_offsets.data(), keys.data(), data.data());
+}
+
+#endif /* BULK_LOADER_H */
@@ -0,0 +1,210 @@
+#ifndef HASH_BUCKET_H
+#define HASH_BUCKET_H
+
+// -------------------- DEFINES --------------------
+#ifndef BUCKET_INLINE_ENTRIES
+#define BUCKET_INLINE_ENTRIES 2
+#endif
+
+// -------------------- LIBRARIES --------------------
+#include <utility>
+#include "AVL_Tree/rankedAVLTree.h"
+
+// --------------------- READ ME ---------------------
+// Hash table bucket: up to BUCKET_INLINE_ENTRIES entries are kept sorted inside the bucket itself,
+// an insert past that moves the bucket into an AVL tree, which keeps O(log n) buckets under adversarial keys.
+// A lookup in a small bucket reads only the bucket, no tree header and no node.
+// Build with -DBUCKET_INLINE_ENTRIES=0 to get a tree for every bucket, the inline path is compiled out then.
+// Memory: every bucket, empty or not, holds the inline slots, BUCKET_INLINE_ENTRIES * (sizeof(int) +
+// sizeof(dataType)) bytes on top of its size and tree pointer (16 bytes for int data with the default 2 slots).
+// Vacated inline slots are reset to dataType(), so removed data is released at once, not on the bucket's destruction.
+// A tree bucket that shrinks to BUCKET_INLINE_ENTRIES / 2 entries moves back inline (the gap avoids flapping).
+// Functions: insert, remove, find, clear, getNodeCounter, isTree, exportInorder, buildFromSorted.
+// With AVL_STATS_ON: getHeight (inline buckets count as height 0), getMemoryBytes.
+
+// inline slots of a bucket, there are none without inline entries
+template<class dataType, int entries>
+struct BucketInlineSlots {
+    int keys[entries];
+    dataType data[entries];
+};
+
+template<class dataType>
+struct BucketInlineSlots<dataType, 0> {
+};
+
+template<class dataType>
+class HashBucket {
+
+private:
+    int inline_size;
+    BucketInlineSlots<dataType, BUCKET_INLINE_ENTRIES> slots;
+    Tree<int, dataType> *tree;
+
+    void moveToTree() {
+        tree = new Tree<int, dataType>;
+        if constexpr (BUCKET_INLINE_ENTRIES > 0)
+            tree->buildFromSorted(slots.keys, slots.data, nullptr, inline_size);
+        clearInline();
+    }
+
+    // resets the used inline slots, so the data they held releases what it owns now and not on destruction
+    void clearInline() {
+        if constexpr (BUCKET_INLINE_ENTRIES > 0) {
+            for (int i = 0; i < inline_size; i++)
+                slots.data[i] = dataType();
+        }
+        inline_size = 0;
+    }
+
+    void moveToInline() {
+        if constexpr (BUCKET_INLINE_ENTRIES > 0) {
+            inline_size = tree->getNodeCounter();
+            tree->exportInorder(slots.keys, slots.data, nullptr);
+            delete tree;
+            tree = nullptr;
+        }
+    }
+
+public:
+    HashBucket() : inline_size(0), tree(nullptr) {}
+
+    ~HashBucket() {
+        delete tree;
+    }
+
+    HashBucket(const HashBucket &other) = delete;
+
+    HashBucket &operator=(const HashBucket &other) = delete;
+
+    // returns nullptr if the key does not exist
+    dataType *find(int key) {
+        if (tree != nullptr) {
+            auto node = tree->find(key);
+            return node == nullptr ? nullptr : &node->data;
+        }
+        if constexpr (BUCKET_INLINE_ENTRIES > 0) {
+            for (int i = 0; i < inline_size; i++) {
+                if (slots.keys[i] == key)
+                    return slots.data + i;
+            }
+        }
+        return nullptr;
+    }
+
+    // the key must not exist yet, returns the inserted data (valid until the bucket changes)
+    dataType *insert(int key, dataType data) {
+        if (tree == nullptr && inline_size == BUCKET_INLINE_ENTRIES)
+            moveToTree();
+        if (tree != nullptr) {
+            auto node = tree->insert(key, data);
+            return node == nullptr ? nullptr : &node->data;
+        }
+        if constexpr (BUCKET_INLINE_ENTRIES > 0) {
+            int position = inline_size;
+            while (position > 0 && key < slots.keys[position - 1]) {
+                slots.keys[position] = slots.keys[position - 1];
+                slots.data[position] = slots.data[position - 1];
+                position--;
+            }
+            slots.keys[position] = key;
+            slots.data[position] = data;
+            inline_size++;
+            return slots.data + position;
+        }
+        return nullptr;
+    }
+
+    // returns false if the key does not exist, else moves its data to "removed" (if not nullptr) and removes it
+    bool remove(int key, dataType *removed = nullptr) {
+        if (tree != nullptr) {
+            auto node = tree->find(key);
+            if (node == nullptr)
+                return false;
+            if (removed != nullptr)
+                *removed = std::move(node->data);
+            tree->remove(node);
+            if (BUCKET_INLINE_ENTRIES > 0 && tree->getNodeCounter() <= BUCKET_INLINE_ENTRIES / 2)
+                moveToInline();
+            return true;
+        }
+        if constexpr (BUCKET_INLINE_ENTRIES > 0) {
+            int position = 0;
+            while (position < inline_size && slots.keys[position] != key)
+                position++;
+            if (position == inline_size)
+                return false;
+            if (removed != nullptr)
+                *removed = std::move(slots.data[position]);
+            for (inline_size--; position < inline_size; position++) {
+                slots.keys[position] = slots.keys[position + 1];
+                slots.data[position] = std::move(slots.data[position + 1]);
+            }
+            slots.data[inline_size] = dataType(); // the vacated last slot
+            return true;
+        }
+        return false;
+    }
+
+    void clear() {
+        delete tree;
+        tree = nullptr;
+        clearInline();
+    }
+
+    int getNodeCounter() const {
+        return tree == nullptr ? inline_size : tree->getNodeCounter();
+    }
+
+    bool isTree() const {
+        return tree != nullptr;
+    }
+
+    // writes the keys and data in ascending key order
+    void exportInorder(int *keys, dataType *data) const {
+        if (tree != nullptr) {
+            tree->exportInorder(keys, data, nullptr);
+            return;
+        }
+        if constexpr (BUCKET_INLINE_ENTRIES > 0) {
+            for (int i = 0; i < inline_size; i++) {
+                keys[i] = slots.keys[i];
+                data[i] = slots.data[i];
+            }
+        }
+    }
+
+    // replaces the bucket content with "size" entries given in strictly ascending key order
+    void buildFromSorted(const int *keys, const dataType *data, int size) {
+        clear();
+        if (size > BUCKET_INLINE_ENTRIES) {
+            tree = new Tree<int, dataType>;
+            tree->buildFromSorted(keys, data, nullptr, size);
+            return;
+        }
+        if constexpr (BUCKET_INLINE_ENTRIES > 0) {
+            for (int i = 0; i < size; i++) {
+                slots.keys[i] = keys[i];
+                slots.data[i] = data[i];
+            }
+            inline_size = size;
+        }
+    }
+
+    // -------------- STATS FUNCTIONS --------------
+#ifdef AVL_STATS_ON
+
+    int getHeight() const {
+        if (tree != nullptr)
+            return tree->getHeight();
+        return inline_size == 0 ? -1 : 0;
+    }
+
+    long long getMemoryBytes() const {
+        return (long long) sizeof(*this) + (tree == nullptr ? 0 : tree->getMemoryBytes());
+    }
+
+#endif /* AVL_STATS_ON */
+};
+
+#endif /* HASH_BUCKET_H */
@@ -4,76 +4,341 @@
 // -------------------- DEFINES --------------------
 #define INITIAL_HASH_SIZE 3
 #define INCREASE_HASH_SIZE_MULTIPLES 2
+#define SHRINK_LOAD_DIVISOR 4 // shrink when less than one entry per 4 buckets
+#define REHASH_BUILD_BUCKETS 64 // new buckets constructed by every insert / remove while rehashing
+#define REHASH_STEP_BUCKETS 16 // old buckets moved by every insert / remove while rehashing
 
 // -------------------- LIBRARIES --------------------
-#include "AVLTree/rankedAVLTree.h"
+#include <cstdint>
+#include <new>
+#include <vector>
+#include "hashBucket.h"
+#include "AVL_Tree/backgroundReclaimer.h"
 
 // --------------------- READ ME ---------------------
-// This templated chain hash table that every bucket point to AVL tree.
+// This templated chain hash table, small buckets hold their entries inline and bigger ones an AVL tree
+// (see hashBucket.h).
 // Amortized analysis on average input: O(1)
-// Functions: init, insert, getData, nodeExist.
+// The table grows when it holds one entry per bucket and halves when it falls below 1 / SHRINK_LOAD_DIVISOR,
+// both land on about 1 / 2 so a table does not flap between sizes.
+// Rehash is incremental, every insert / remove does a bounded part of it, no operation pays for a whole one:
+// first the new bucket array is constructed REHASH_BUILD_BUCKETS buckets at a time (the table keeps using
+// the current array), then REHASH_STEP_BUCKETS old buckets at a time are moved to it. While moving, lookups
+// check the old bucket of a key until it was moved. The emptied old array is then destructed and freed.
+// Functions: init, insert, remove, find, getData, nodeExist, finishRehash, isRehashing.
+// insert - returns the data of the new entry, or nullptr when the key exists (its data is kept), so a caller
+// can insert if absent and fill the entry with one hash of the key.
+// getBucket / buildFromSorted - access the buckets and rebuild the table from per bucket sorted arrays,
+// hashSizeFor - the hash size the table grows to for a number of entries (to presize buildFromSorted).
+// setBackgroundDestruction - opt-in, the destructor and buildFromSorted hand the old bucket arrays (and the bucket
+// trees) to the BackgroundReclaimer thread, so destroying or replacing a big table costs O(1) on its owner thread.
+// With AVL_STATS_ON: getLoadFactor, getBucketDepthHistogram, getTreeHeightHistogram, getMemoryBytes, dumpStats.
 
 template<class dataType>
 class HashTable {
 
 private:
-    Tree<int, dataType> *buckets;
+    HashBucket<dataType> *buckets;
     int hash_size;
     int hash_nodes_counter;
+    HashBucket<dataType> *next_buckets; // array under construction, nullptr if there is none
+    int next_hash_size;
+    int built_buckets;
+    HashBucket<dataType> *old_buckets; // buckets being moved out, nullptr if there are none
+    int old_hash_size;
+    int moved_buckets; // old buckets below this index are already moved (and empty)
+    std::vector<int> move_keys;
+    std::vector<dataType> move_data;
+    bool background_destruction;
 
     int hashFunction(int key) const {
-        return key % hash_size;
+        return hashFunction(key, hash_size);
     }
 
-public:
-    HashTable() : hash_size(INITIAL_HASH_SIZE), hash_nodes_counter(0) {
-        buckets = new Tree<int, dataType>[hash_size];
+    static HashBucket<dataType> *allocateBuckets(int size) {
+        return (HashBucket<dataType> *) operator new(sizeof(HashBucket<dataType>) * size);
+    }
+
+    static HashBucket<dataType> *newBuckets(int size) {
+        HashBucket<dataType> *array = allocateBuckets(size);
+        for (int i = 0; i < size; i++)
+            new(array + i) HashBucket<dataType>();
+        return array;
     }
 
-    void insert(int new_key, dataType new_data) {
-        int index = hashFunction(new_key);
-        if (nodeExist(new_key))
+    // "built" first buckets of "array" are constructed
+    static void deleteBuckets(HashBucket<dataType> *array, int built) {
+        if (array == nullptr)
             return;
+        for (int i = 0; i < built; i++)
+            array[i].~HashBucket<dataType>();
+        operator delete(array);
+    }
 
-        buckets[index].insert(new_key, new_data);
-        hash_nodes_counter += 1;
+    // frees the current, the next and the old bucket array, on the reclaimer thread in background destruction mode
+    void releaseBuckets() {
+        if (background_destruction) {
+            HashBucket<dataType> *arrays[] = {buckets, next_buckets, old_buckets};
+            int built[] = {hash_size, built_buckets, old_hash_size};
+            BackgroundReclaimer::instance().retire([arrays, built]() {
+                for (int i = 0; i < 3; i++)
+                    deleteBuckets(arrays[i], built[i]);
+            });
+        }
+        else {
+            deleteBuckets(buckets, hash_size);
+            deleteBuckets(next_buckets, built_buckets);
+            deleteBuckets(old_buckets, old_hash_size);
+        }
+        buckets = next_buckets = old_buckets = nullptr;
+    }
+
+    // the bucket holding "key" if it exists, the bucket to insert it to otherwise
+    HashBucket<dataType> &bucketOf(int key) {
+        if (old_buckets != nullptr) {
+            int old_index = hashFunction(key, old_hash_size);
+            if (old_index >= moved_buckets && old_buckets[old_index].find(key) != nullptr)
+                return old_buckets[old_index];
+        }
+        return buckets[hashFunction(key)];
+    }
+
+    void buildStep(int steps) {
+        for (; steps > 0 && built_buckets < next_hash_size; steps--, built_buckets++)
+            new(next_buckets + built_buckets) HashBucket<dataType>();
+        if (built_buckets < next_hash_size)
+            return;
+        old_buckets = buckets;
+        old_hash_size = hash_size;
+        moved_buckets = 0;
+        buckets = next_buckets;
+        hash_size = next_hash_size;
+        next_buckets = nullptr;
+    }
+
+    void moveStep(int steps) {
+        for (; steps > 0 && moved_buckets < old_hash_size; steps--, moved_buckets++) {
+            HashBucket<dataType> &bucket = old_buckets[moved_buckets];
+            int bucket_size = bucket.getNodeCounter();
+            move_keys.resize(bucket_size);
+            move_data.resize(bucket_size);
+            bucket.exportInorder(move_keys.data(), move_data.data());
+            for (int j = 0; j < bucket_size; j++)
+                buckets[hashFunction(move_keys[j])].insert(move_keys[j], move_data[j]);
+            bucket.clear();
+        }
+        move_data.clear(); // no copy of a moved entry outlives the step
+        if (moved_buckets < old_hash_size)
+            return;
+        deleteBuckets(old_buckets, old_hash_size); // the emptied buckets still own their inline slots
+        old_buckets = nullptr;
+        AVL_STATS_ADD(STATS_REHASHES, 1);
+    }
 
-        if (hash_nodes_counter / hash_size == 1) {
-            int old_hash_size = hash_size;
-            hash_size = hash_size * INCREASE_HASH_SIZE_MULTIPLES - 1;
-            try {
-                auto *new_buckets = new Tree<int, dataType>[hash_size];
-
-                for (int i = 0; i < old_hash_size; i++) {
-                    while (buckets[i].getRoot() != nullptr) {
-                        int move_key = buckets[i].getRoot()->key;
-                        int new_index = hashFunction(move_key);
-                        dataType move_data =  buckets[i].getRoot()->data;
-                        new_buckets[new_index].insert(move_key, move_data);
-                        buckets[i].remove(move_key);
-                    }
-                }
-                delete[] buckets;
-                buckets = new_buckets;
-            }
-            catch (std::bad_alloc &e) {
-                hash_size = old_hash_size;
-                throw;
-            }
+    void rehashStep(int build_steps, int move_steps) {
+        if (!isRehashing())
+            return;
+#ifdef AVL_STATS_ON
+        auto rehash_start = std::chrono::steady_clock::now();
+#endif /* AVL_STATS_ON */
+        if (next_buckets != nullptr)
+            buildStep(build_steps);
+        else
+            moveStep(move_steps);
+#ifdef AVL_STATS_ON
+        AVL_STATS_ADD(STATS_REHASH_NANOSECONDS, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - rehash_start).count());
+#endif /* AVL_STATS_ON */
+    }
+
+    // starts moving the entries to "new_hash_size" buckets, a rehash still running is finished first
+    void startRehash(int new_hash_size) {
+        finishRehash();
+        next_buckets = allocateBuckets(new_hash_size);
+        next_hash_size = new_hash_size;
+        built_buckets = 0;
+    }
+
+public:
+    HashTable() : hash_size(INITIAL_HASH_SIZE), hash_nodes_counter(0), next_buckets(nullptr), next_hash_size(0),
+                  built_buckets(0), old_buckets(nullptr), old_hash_size(0), moved_buckets(0),
+                  background_destruction(false) {
+        buckets = newBuckets(hash_size);
+    }
+
+    ~HashTable() {
+        releaseBuckets();
+    }
+
+    HashTable(const HashTable &other) = delete;
+
+    HashTable &operator=(const HashTable &other) = delete;
+
+    // the hash size this table reaches by growing to hold "nodes" entries, the first one bigger than "nodes"
+    static int hashSizeFor(int nodes) {
+        int size = INITIAL_HASH_SIZE;
+        while (size <= nodes)
+            size = size * INCREASE_HASH_SIZE_MULTIPLES - 1;
+        return size;
+    }
+
+    static int hashFunction(int key, int size) {
+        int index = key % size;
+        return index < 0 ? index + size : index;
+    }
+
+    // returns the inserted data, valid until the next insert or remove, nullptr if the key already exists.
+    // the rehash step runs first, so no entry moves after the key was inserted.
+    dataType *insert(int new_key, dataType new_data) {
+        rehashStep(REHASH_BUILD_BUCKETS, REHASH_STEP_BUCKETS);
+        if (old_buckets != nullptr) {
+            int old_index = hashFunction(new_key, old_hash_size);
+            if (old_index >= moved_buckets && old_buckets[old_index].find(new_key) != nullptr)
+                return nullptr;
         }
+        HashBucket<dataType> &bucket = buckets[hashFunction(new_key)];
+        if (bucket.find(new_key) != nullptr)
+            return nullptr;
+
+        dataType *inserted = bucket.insert(new_key, new_data);
+        hash_nodes_counter += 1;
+
+        if (!isRehashing() && hash_nodes_counter >= hash_size)
+            startRehash(hash_size * INCREASE_HASH_SIZE_MULTIPLES - 1); // allocates only, moves no entry
+        return inserted;
+    }
+
+    // one lookup of the key, returns false if it does not exist. Its data is moved to "removed" if not nullptr.
+    bool remove(int key, dataType *removed = nullptr) {
+        if (!bucketOf(key).remove(key, removed))
+            return false;
+        hash_nodes_counter -= 1;
+        rehashStep(REHASH_BUILD_BUCKETS, REHASH_STEP_BUCKETS);
+
+        int shrunk_hash_size = (hash_size + 1) / INCREASE_HASH_SIZE_MULTIPLES;
+        if (!isRehashing() && shrunk_hash_size >= INITIAL_HASH_SIZE &&
+            hash_nodes_counter * SHRINK_LOAD_DIVISOR < hash_size)
+            startRehash(shrunk_hash_size);
+        return true;
+    }
+
+    void setBackgroundDestruction(bool background) {
+        background_destruction = background;
+    }
+
+    // completes a running rehash at once, getBucket needs it
+    void finishRehash() {
+        while (isRehashing())
+            rehashStep(next_hash_size, old_hash_size);
+    }
+
+    bool isRehashing() const {
+        return next_buckets != nullptr || old_buckets != nullptr;
+    }
+
+    // returns nullptr if the key does not exist, one lookup instead of nodeExist + getData
+    dataType *find(int key) {
+        return bucketOf(key).find(key);
     }
 
     bool nodeExist(int key) {
-        int index = hashFunction(key);
-        if (buckets[index].find(key))
-            return true;
-        return false;
+        return find(key) != nullptr;
     }
 
     dataType& getData(int key) {
-        int index = hashFunction(key);
-        return buckets[index].find(key)->data;
+        return *bucketOf(key).find(key);
+    }
+
+    int getHashSize() const {
+        return hash_size;
+    }
+
+    int getNodesCounter() const {
+        return hash_nodes_counter;
+    }
+
+    // valid only while no rehash runs (see finishRehash)
+    const HashBucket<dataType> &getBucket(int index) const {
+        return buckets[index];
     }
+
+    // replaces the table content without rehashing: bucket "i" gets the entries in the range
+    // [bucket_offsets[i], bucket_offsets[i + 1]) of "keys" and "data", sorted by key.
+    void buildFromSorted(int new_hash_size, const uint64_t *bucket_offsets, const int *keys,
+                         const dataType *data) {
+        auto *new_buckets = newBuckets(new_hash_size);
+        for (int i = 0; i < new_hash_size; i++) {
+            int first = (int) bucket_offsets[i];
+            int bucket_size = (int) (bucket_offsets[i + 1] - bucket_offsets[i]);
+            new_buckets[i].buildFromSorted(keys + first, data + first, bucket_size);
+        }
+        releaseBuckets(); // a running rehash is dropped with the old content
+        buckets = new_buckets;
+        hash_size = new_hash_size;
+        hash_nodes_counter = (int) bucket_offsets[new_hash_size];
+    }
+
+    // -------------- STATS FUNCTIONS --------------
+#ifdef AVL_STATS_ON
+
+    double getLoadFactor() const {
+        return (double) hash_nodes_counter / hash_size;
+    }
+
+    // histogram[i] = number of buckets holding i entries, the histograms cover the new buckets only
+    std::vector<long long> getBucketDepthHistogram() const {
+        std::vector<long long> histogram;
+        for (int i = 0; i < hash_size; i++) {
+            int depth = buckets[i].getNodeCounter();
+            if (depth >= (int) histogram.size())
+                histogram.resize(depth + 1);
+            histogram[depth]++;
+        }
+        return histogram;
+    }
+
+    // histogram[i] = number of buckets whose tree height is i - 1 (the first cell counts empty buckets,
+    // inline buckets count as height 0)
+    std::vector<long long> getTreeHeightHistogram() const {
+        std::vector<long long> histogram;
+        for (int i = 0; i < hash_size; i++) {
+            int cell = buckets[i].getHeight() + 1;
+            if (cell >= (int) histogram.size())
+                histogram.resize(cell + 1);
+            histogram[cell]++;
+        }
+        return histogram;
+    }
+
+    long long getMemoryBytes() const {
+        long long bytes = sizeof(*this);
+        for (int i = 0; i < hash_size; i++)
+            bytes += buckets[i].getMemoryBytes();
+        for (int i = 0; old_buckets != nullptr && i < old_hash_size; i++)
+            bytes += old_buckets[i].getMemoryBytes();
+        if (next_buckets != nullptr)
+            bytes += (long long) sizeof(HashBucket<dataType>) * next_hash_size;
+        return bytes;
+    }
+
+    // JSON object with the global counters and the shape of this table
+    void dumpStats(std::ostream &stream) const {
+        stream << "{";
+        dumpTreeStatsMembers(stream);
+        stream << ", \"nodes\": " << hash_nodes_counter << ", \"hash_size\": " << hash_size
+               << ", \"load_factor\": " << getLoadFactor() << ", \"memory_bytes\": " << getMemoryBytes();
+        std::vector<long long> histograms[] = {getBucketDepthHistogram(), getTreeHeightHistogram()};
+        const char *names[] = {"bucket_depth_histogram", "tree_height_histogram"};
+        for (int i = 0; i < 2; i++) {
+            stream << ", \"" << names[i] << "\": [";
+            for (size_t j = 0; j < histograms[i].size(); j++)
+                stream << (j > 0 ? ", " : "") << histograms[i][j];
+            stream << "]";
+        }
+        stream << "}";
+    }
+
+#endif /* AVL_STATS_ON */
 };
 
 #endif /* HASH_TABLE_H */
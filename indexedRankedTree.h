@@ -0,0 +1,84 @@
+#ifndef INDEXED_RANKED_TREE_H
+#define INDEXED_RANKED_TREE_H
+
+// -------------------- LIBRARIES --------------------
+#include "hashTable.h"
+#include "AVL_Tree/rankedAVLTree.h"
+
+// --------------------- READ ME ---------------------
+// Ranked tree with a hash index: the HashTable maps a key straight to its node in the ranked Tree
+// (a stable handle, the tree never moves data between nodes), so the data is stored once, in the node.
+// The tree is never compacted: Tree::compact moves the nodes and would leave the index dangling, so the tree
+// keeps the default HeapStorage (without compact) and getTree gives const access only.
+// find - O(1) on average, one hash lookup and no tree walk.
+// insert / remove - O(log n), one tree update plus one hash update (remove finds the node through the index).
+// upgradeRank, getNodeRank and the ordered queries run on the tree (getTree gives read only access to it).
+// Functions: insert, remove, find, nodeExist, upgradeRank, getNodeRank, topK, getNodeCounter, getTree.
+
+template<class dataType, class rankType = double>
+class IndexedTree {
+
+private:
+    typedef Tree<int, dataType, rankType, AVLBalance, MaxRankAugment> RankedTree; // the max ranks for topK
+    typedef typename RankedTree::Node Node;
+
+    RankedTree tree;
+    HashTable<Node *> index;
+
+public:
+    IndexedTree() = default;
+
+    IndexedTree(const IndexedTree &other) = delete;
+
+    IndexedTree &operator=(const IndexedTree &other) = delete;
+
+    // the tree first: a failed node allocation leaves no index entry. One hash of the key, the index entry
+    // is added only for a new node (and the node removed again if the index could not take it).
+    void insert(int key, dataType data) {
+        int nodes_counter = tree.getNodeCounter();
+        Node *node = tree.insert(key, data);
+        if (node == nullptr || tree.getNodeCounter() == nodes_counter)
+            return;
+        if (index.insert(key, node) == nullptr)
+            tree.remove(node);
+    }
+
+    // one hash lookup that removes the index entry and gives its node, then one tree walk to remove it
+    void remove(int key) {
+        Node *node;
+        if (index.remove(key, &node))
+            tree.remove(node);
+    }
+
+    // returns nullptr if the key does not exist
+    dataType *find(int key) {
+        Node **node = index.find(key);
+        return node == nullptr ? nullptr : &(*node)->data;
+    }
+
+    bool nodeExist(int key) {
+        return index.nodeExist(key);
+    }
+
+    void upgradeRank(int key_1, int key_2, rankType amount) {
+        tree.upgradeRank(key_1, key_2, amount);
+    }
+
+    rankType getNodeRank(int key) const {
+        return tree.getNodeRank(key);
+    }
+
+    int topK(int k, int *keys, dataType *data, rankType *ranks) const {
+        return tree.topK(k, keys, data, ranks);
+    }
+
+    int getNodeCounter() const {
+        return tree.getNodeCounter();
+    }
+
+    const RankedTree &getTree() const {
+        return tree;
+    }
+};
+
+#endif /* INDEXED_RANKED_TREE_H */
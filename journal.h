@@ -0,0 +1,422 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+// -------------------- LIBRARIES --------------------
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <exception>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ------------------ INCLUDE FILES ------------------
+#include "snapshot.h"
+
+// -------------------- DEFINES --------------------
+#define JOURNAL_BATCH_MAGIC 0x4c4e524au // "JRNL"
+#define JOURNAL_DEFAULT_BATCH_SIZE 256
+#define JOURNAL_FNV_OFFSET 2166136261u
+#define JOURNAL_FNV_PRIME 16777619u
+
+// --------------------- READ ME ---------------------
+// Append only write ahead journal of insert / remove / upgradeRank operations.
+// Log every operation before applying it. Operations are buffered and written with one write + fsync
+// per "batch_size" operations (group commit), so a crash loses at most the last unsynced batch.
+// File layout: a sequence of batches, every batch is: magic | records length | checksum | operations number |
+// sequence | records. The operations are numbered 1, 2, 3... for the whole life of the journal (across resets),
+// "sequence" is the number of the first record of the batch, the checksum covers the number, the sequence and
+// the records.
+// A record is: operation (1 byte) | key | data (insert) or key_2 and amount (upgradeRank).
+// Recovery checks every batch before it applies any record: a torn or corrupted tail batch ends the replay and is
+// cut off the file, so the batches logged after the recovery directly follow the last valid one. A batch with a
+// valid checksum whose records do not fit it (written for other key / data types) throws journalError.
+// Checkpoint: sync, save a snapshot holding the last journal sequence, then reset the journal (checkpoint does
+// all three). A recovery replays only the records after the sequence of the snapshot, so a crash between the
+// snapshot and the reset does not apply an upgradeRank twice. reset replaces the file by a rename, the new file
+// starts with an empty batch that keeps the numbering going.
+// Functions: logInsert, logRemove, logUpgradeRank, sync, reset, checkpoint, getSequence.
+// replayJournal - apply a journal to a Tree / HashTable, recover - load a snapshot and replay on top of it.
+// The HashTable has no ranks, its replay skips upgradeRank records.
+
+// ---------------- JOURNAL EXCEPTION ----------------
+class journalError : public std::exception {
+public:
+    const char *what() const noexcept override {
+        return "Journal error";
+    }
+};
+
+enum JournalOperation : uint8_t {
+    JOURNAL_INSERT = 1,
+    JOURNAL_REMOVE = 2,
+    JOURNAL_UPGRADE_RANK = 3
+};
+
+struct JournalBatchHeader {
+    uint32_t magic;
+    uint32_t length;
+    uint32_t checksum;
+    uint32_t operations;
+    uint64_t sequence;
+};
+
+static inline uint32_t journalChecksum(const char *buffer, size_t length, uint32_t hash = JOURNAL_FNV_OFFSET) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t) buffer[i];
+        hash *= JOURNAL_FNV_PRIME;
+    }
+    return hash;
+}
+
+static inline uint32_t journalBatchChecksum(const JournalBatchHeader &header, const char *records) {
+    uint32_t hash = journalChecksum((const char *) &header.operations, sizeof(header.operations));
+    hash = journalChecksum((const char *) &header.sequence, sizeof(header.sequence), hash);
+    return journalChecksum(records, header.length, hash);
+}
+
+// the bytes after the operation byte, 0 for an unknown operation
+template<class keyType, class dataType>
+static inline size_t journalRecordSize(uint8_t operation) {
+    if (operation == JOURNAL_INSERT)
+        return sizeof(keyType) + sizeof(dataType);
+    if (operation == JOURNAL_REMOVE)
+        return sizeof(keyType);
+    if (operation == JOURNAL_UPGRADE_RANK)
+        return 2 * sizeof(int) + sizeof(double);
+    return 0;
+}
+
+// reads the whole journal file, false if there is none
+static inline bool readJournalFile(const char *path, std::vector<char> &content) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    char chunk[1 << 16];
+    ssize_t bytes_read;
+    while ((bytes_read = read(fd, chunk, sizeof(chunk))) != 0) {
+        if (bytes_read < 0 && errno == EINTR)
+            continue;
+        if (bytes_read < 0) {
+            close(fd);
+            throw journalError();
+        }
+        content.insert(content.end(), chunk, chunk + bytes_read);
+    }
+    close(fd);
+    return true;
+}
+
+// returns the length of the valid batches at the start of "content" (the rest is a torn tail) and sets
+// "next_sequence" after their last record. Every record of a valid batch must fit inside it.
+template<class keyType, class dataType>
+size_t journalValidLength(const std::vector<char> &content, uint64_t &next_sequence) {
+    size_t offset = 0;
+    while (offset + sizeof(JournalBatchHeader) <= content.size()) {
+        JournalBatchHeader header{};
+        memcpy(&header, content.data() + offset, sizeof(header));
+        const char *batch = content.data() + offset + sizeof(header);
+        if (header.magic != JOURNAL_BATCH_MAGIC || header.length > content.size() - offset - sizeof(header) ||
+            journalBatchChecksum(header, batch) != header.checksum)
+            break; // torn tail
+        const char *record = batch;
+        const char *batch_end = batch + header.length;
+        uint32_t operations = 0;
+        while (record < batch_end) {
+            size_t record_size = journalRecordSize<keyType, dataType>((uint8_t) *record);
+            if (record_size == 0 || record_size > (size_t) (batch_end - record - 1))
+                throw journalError();
+            record += 1 + record_size;
+            operations++;
+        }
+        if (operations != header.operations)
+            throw journalError();
+        next_sequence = header.sequence + header.operations;
+        offset += sizeof(header) + header.length;
+    }
+    return offset;
+}
+
+// cuts the file at "length" durably
+static inline void truncateJournal(int fd, size_t length) {
+    if (ftruncate(fd, (off_t) length) != 0 || fdatasync(fd) != 0)
+        throw journalError();
+}
+
+// ------------------ JOURNAL CLASS ------------------
+template<class keyType, class dataType>
+class Journal {
+private:
+    std::string path;
+    int fd;
+    int batch_size;
+    int pending_operations;
+    uint64_t next_sequence; // the number of the next logged operation
+    std::vector<char> records;
+
+    template<class valueType>
+    void append(const valueType &value) {
+        const char *bytes = (const char *) &value;
+        records.insert(records.end(), bytes, bytes + sizeof(valueType));
+    }
+
+    void clearRecords() {
+        records.assign(sizeof(JournalBatchHeader), 0);
+        pending_operations = 0;
+    }
+
+    void operationLogged() {
+        pending_operations++;
+        next_sequence++;
+        if (pending_operations >= batch_size)
+            sync();
+    }
+
+    static void writeAll(int fd, const char *buffer, size_t length) {
+        while (length > 0) {
+            ssize_t written = write(fd, buffer, length);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written < 0)
+                throw journalError();
+            buffer += written;
+            length -= (size_t) written;
+        }
+    }
+
+    // fills the batch header in front of "batch_records" (which starts with the space kept for it)
+    void writeBatch(int batch_fd, std::vector<char> &batch_records, int operations) {
+        JournalBatchHeader header{JOURNAL_BATCH_MAGIC, (uint32_t) (batch_records.size() - sizeof(JournalBatchHeader)),
+                                  0, (uint32_t) operations, next_sequence - operations};
+        header.checksum = journalBatchChecksum(header, batch_records.data() + sizeof(header));
+        memcpy(batch_records.data(), &header, sizeof(header));
+        writeAll(batch_fd, batch_records.data(), batch_records.size());
+        if (fdatasync(batch_fd) != 0)
+            throw journalError();
+    }
+
+public:
+    // continues the numbering of an existing journal (its torn tail is cut off first)
+    explicit Journal(const char *path, int batch_size = JOURNAL_DEFAULT_BATCH_SIZE) :
+            path(path), fd(open(path, O_WRONLY | O_CREAT | O_APPEND, 0644)), batch_size(batch_size),
+            pending_operations(0), next_sequence(1) {
+        static_assert(std::is_trivially_copyable<keyType>::value && std::is_trivially_copyable<dataType>::value,
+                      "journal entries must be trivially copyable");
+        if (fd < 0)
+            throw journalError();
+        try {
+            std::vector<char> content;
+            readJournalFile(path, content);
+            size_t valid_length = journalValidLength<keyType, dataType>(content, next_sequence);
+            if (valid_length < content.size())
+                truncateJournal(fd, valid_length);
+        }
+        catch (const journalError &) {
+            close(fd);
+            throw;
+        }
+        if (this->batch_size < 1)
+            this->batch_size = 1;
+        records.reserve(sizeof(JournalBatchHeader) +
+                        this->batch_size * (1 + sizeof(keyType) + sizeof(dataType) + sizeof(double)));
+        clearRecords();
+    }
+
+    ~Journal() {
+        try {
+            sync();
+        }
+        catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+        }
+        close(fd);
+    }
+
+    Journal(const Journal &other) = delete;
+
+    Journal &operator=(const Journal &other) = delete;
+
+    void logInsert(const keyType key, const dataType data) {
+        records.push_back((char) JOURNAL_INSERT);
+        append(key);
+        append(data);
+        operationLogged();
+    }
+
+    void logRemove(const keyType key) {
+        records.push_back((char) JOURNAL_REMOVE);
+        append(key);
+        operationLogged();
+    }
+
+    void logUpgradeRank(int key_1, int key_2, double amount) {
+        records.push_back((char) JOURNAL_UPGRADE_RANK);
+        append(key_1);
+        append(key_2);
+        append(amount);
+        operationLogged();
+    }
+
+    // writes the pending batch with a single write and makes it durable
+    void sync() {
+        if (pending_operations == 0)
+            return;
+        writeBatch(fd, records, pending_operations);
+        clearRecords();
+    }
+
+    // drops the journal content, once a snapshot holding getSequence() was saved (see checkpoint).
+    // the new content (an empty batch carrying the numbering) is written aside and renamed over the journal,
+    // so a crash leaves either the old journal or the new one.
+    void reset() {
+        clearRecords();
+        std::string temporary_path = path + ".tmp";
+        int new_fd = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (new_fd < 0)
+            throw journalError();
+        try {
+            writeBatch(new_fd, records, 0);
+            clearRecords();
+            if (rename(temporary_path.c_str(), path.c_str()) != 0 || !syncDirectory(path.c_str()))
+                throw journalError();
+        }
+        catch (const journalError &) {
+            close(new_fd);
+            unlink(temporary_path.c_str());
+            throw;
+        }
+        close(fd);
+        fd = new_fd;
+    }
+
+    // syncs the journal, saves a snapshot of "structure" (which holds every logged operation) and resets
+    template<class structureType>
+    void checkpoint(structureType &structure, const char *snapshot_path) {
+        sync();
+        saveSnapshot(structure, snapshot_path, getSequence());
+        reset();
+    }
+
+    // the number of the last logged operation, 0 if none was logged yet
+    uint64_t getSequence() const {
+        return next_sequence - 1;
+    }
+
+    int getPendingOperations() const {
+        return pending_operations;
+    }
+};
+
+// ----------------- JOURNAL READER -----------------
+// calls "apply(operation, record)" for every record numbered after "after_sequence" of every complete batch,
+// returns the number of applied records. Every batch is checked before any record is applied.
+// a torn tail is truncated (durably) after the replay, a new batch appended behind it would be lost otherwise.
+template<class keyType, class dataType, class applyFunction>
+long long readJournal(const char *path, uint64_t after_sequence, applyFunction apply) {
+    std::vector<char> content;
+    if (!readJournalFile(path, content))
+        return 0; // no journal - nothing to recover
+    uint64_t next_sequence = 1;
+    size_t valid_length = journalValidLength<keyType, dataType>(content, next_sequence);
+
+    long long operations = 0;
+    size_t offset = 0;
+    while (offset < valid_length) {
+        JournalBatchHeader header{};
+        memcpy(&header, content.data() + offset, sizeof(header));
+        const char *record = content.data() + offset + sizeof(header);
+        for (uint64_t sequence = header.sequence; sequence < header.sequence + header.operations; sequence++) {
+            JournalOperation operation = (JournalOperation) *record;
+            if (sequence > after_sequence) {
+                apply(operation, record + 1);
+                operations++;
+            }
+            record += 1 + journalRecordSize<keyType, dataType>(operation);
+        }
+        offset += sizeof(header) + header.length;
+    }
+    if (valid_length < content.size()) {
+        int fd = open(path, O_WRONLY);
+        if (fd < 0)
+            throw journalError();
+        try {
+            truncateJournal(fd, valid_length);
+        }
+        catch (const journalError &) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+    }
+    return operations;
+}
+
+template<class valueType>
+static inline const char *journalRead(const char *record, valueType &value) {
+    memcpy(&value, record, sizeof(valueType));
+    return record + sizeof(valueType);
+}
+
+// ------------------ TREE RECOVERY ------------------
+template<class keyType, class dataType>
+long long replayJournal(const char *path, Tree<keyType, dataType> &tree, uint64_t after_sequence = 0) {
+    return readJournal<keyType, dataType>(path, after_sequence, [&tree](JournalOperation operation,
+                                                                        const char *record) {
+        if (operation == JOURNAL_INSERT) {
+            keyType key;
+            dataType data;
+            record = journalRead(record, key);
+            journalRead(record, data);
+            tree.insert(key, data);
+        }
+        else if (operation == JOURNAL_REMOVE) {
+            keyType key;
+            journalRead(record, key);
+            tree.remove(key);
+        }
+        else {
+            int key_1, key_2;
+            double amount;
+            record = journalRead(record, key_1);
+            record = journalRead(record, key_2);
+            journalRead(record, amount);
+            tree.upgradeRank(key_1, key_2, amount);
+        }
+    });
+}
+
+// loads the snapshot and replays the journal records it does not hold yet
+template<class keyType, class dataType>
+long long recover(Tree<keyType, dataType> &tree, const char *snapshot_path, const char *journal_path) {
+    uint64_t snapshot_sequence = loadSnapshot(tree, snapshot_path);
+    return replayJournal(journal_path, tree, snapshot_sequence);
+}
+
+// --------------- HASH TABLE RECOVERY ---------------
+template<class dataType>
+long long replayJournal(const char *path, HashTable<dataType> &table, uint64_t after_sequence = 0) {
+    return readJournal<int, dataType>(path, after_sequence, [&table](JournalOperation operation,
+                                                                     const char *record) {
+        int key;
+        record = journalRead(record, key);
+        if (operation == JOURNAL_INSERT) {
+            dataType data;
+            journalRead(record, data);
+            table.insert(key, data);
+        }
+        else if (operation == JOURNAL_REMOVE) {
+            table.remove(key);
+        }
+        // an upgradeRank record changes nothing in a table without ranks
+    });
+}
+
+template<class dataType>
+long long recover(HashTable<dataType> &table, const char *snapshot_path, const char *journal_path) {
+    uint64_t snapshot_sequence = loadSnapshot(table, snapshot_path);
+    return replayJournal(journal_path, table, snapshot_sequence);
+}
+
+#endif /* JOURNAL_H */
@@ -0,0 +1,159 @@
+#ifndef SHARDED_HASH_TABLE_H
+#define SHARDED_HASH_TABLE_H
+
+// -------------------- DEFINES --------------------
+#define SHARD_ALIGNMENT 64 // cache line
+#define SHARD_HASH_MULTIPLIER 0x9E3779B97F4A7C15ull
+
+// -------------------- LIBRARIES --------------------
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <future>
+#include <vector>
+#include <memory>
+#include "hashTable.h"
+
+// --------------------- READ ME ---------------------
+// Thread safe front-end of N independent HashTable shards, every shard has its own lock and cache lines.
+// The shard is chosen by the high bits of a multiplicative hash of the key, so it does not depend on the
+// low bits the shard HashTable uses for its own buckets. Every shard grows (rehashes) by itself,
+// a rehash locks only its own shard.
+// Functions: insert, remove, nodeExist, getData (by value, the node may move on a rehash), getNodesCounter.
+// insertBulk / nodeExistBulk - group the keys by shard, then run every group under one lock, on "threads" threads.
+
+template<class dataType>
+class ShardedHashTable {
+
+private:
+    struct alignas(SHARD_ALIGNMENT) Shard {
+        std::mutex lock;
+        HashTable<dataType> table;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    int shards_number;
+    int shard_bits;
+
+    // indexes of the keys of every shard: shard "i" owns order[offsets[i]] .. order[offsets[i + 1] - 1]
+    void groupByShard(const int *keys, int size, std::vector<int> &offsets, std::vector<int> &order) const {
+        std::vector<int> shard_of(size);
+        offsets.assign(shards_number + 1, 0);
+        for (int i = 0; i < size; i++) {
+            shard_of[i] = shardIndex(keys[i]);
+            offsets[shard_of[i] + 1]++;
+        }
+        for (int i = 0; i < shards_number; i++)
+            offsets[i + 1] += offsets[i];
+        std::vector<int> next(offsets.begin(), offsets.end() - 1);
+        order.resize(size);
+        for (int i = 0; i < size; i++)
+            order[next[shard_of[i]]++] = i;
+    }
+
+    // runs "work(shard)" for every shard, shards are dealt to the threads round robin
+    template<class workFunction>
+    void forEachShard(int threads, workFunction work) {
+        threads = std::max(1, std::min(threads, shards_number));
+        std::vector<std::future<void>> workers;
+        for (int thread = 1; thread < threads; thread++) {
+            workers.push_back(std::async(std::launch::async, [this, thread, threads, &work]() {
+                for (int shard = thread; shard < shards_number; shard += threads)
+                    work(shard);
+            }));
+        }
+        for (int shard = 0; shard < shards_number; shard += threads)
+            work(shard);
+        for (auto &worker: workers)
+            worker.get();
+    }
+
+public:
+    // "shards_number" is rounded up to a power of two, 0 means one shard per hardware thread
+    explicit ShardedHashTable(int shards_number = 0) : shard_bits(0) {
+        if (shards_number <= 0)
+            shards_number = (int) std::max(1u, std::thread::hardware_concurrency());
+        while ((1 << shard_bits) < shards_number)
+            shard_bits++;
+        this->shards_number = 1 << shard_bits;
+        shards.reset(new Shard[this->shards_number]);
+    }
+
+    ShardedHashTable(const ShardedHashTable &other) = delete;
+
+    ShardedHashTable &operator=(const ShardedHashTable &other) = delete;
+
+    int shardIndex(int key) const {
+        if (shard_bits == 0)
+            return 0;
+        return (int) (((uint64_t) (uint32_t) key * SHARD_HASH_MULTIPLIER) >> (64 - shard_bits));
+    }
+
+    void insert(int new_key, dataType new_data) {
+        Shard &shard = shards[shardIndex(new_key)];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.table.insert(new_key, new_data);
+    }
+
+    void remove(int key) {
+        Shard &shard = shards[shardIndex(key)];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.table.remove(key);
+    }
+
+    bool nodeExist(int key) {
+        Shard &shard = shards[shardIndex(key)];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        return shard.table.nodeExist(key);
+    }
+
+    // the key must exist
+    dataType getData(int key) {
+        Shard &shard = shards[shardIndex(key)];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        return shard.table.getData(key);
+    }
+
+    void insertBulk(const int *keys, const dataType *data, int size, int threads = 1) {
+        std::vector<int> offsets, order;
+        groupByShard(keys, size, offsets, order);
+        forEachShard(threads, [&](int index) {
+            Shard &shard = shards[index];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            for (int i = offsets[index]; i < offsets[index + 1]; i++)
+                shard.table.insert(keys[order[i]], data[order[i]]);
+        });
+    }
+
+    // found[i] = whether keys[i] exists
+    void nodeExistBulk(const int *keys, bool *found, int size, int threads = 1) {
+        std::vector<int> offsets, order;
+        groupByShard(keys, size, offsets, order);
+        forEachShard(threads, [&](int index) {
+            Shard &shard = shards[index];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            for (int i = offsets[index]; i < offsets[index + 1]; i++)
+                found[order[i]] = shard.table.nodeExist(keys[order[i]]);
+        });
+    }
+
+    int getNodesCounter() {
+        int nodes = 0;
+        for (int i = 0; i < shards_number; i++) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            nodes += shards[i].table.getNodesCounter();
+        }
+        return nodes;
+    }
+
+    int getShardsNumber() const {
+        return shards_number;
+    }
+
+    // no locking - only while no other thread uses the table
+    const HashTable<dataType> &getShard(int index) const {
+        return shards[index].table;
+    }
+};
+
+#endif /* SHARDED_HASH_TABLE_H */
@@ -0,0 +1,424 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// -------------------- LIBRARIES --------------------
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <climits>
+#include <exception>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ------------------ INCLUDE FILES ------------------
+#include "hashTable.h"
+
+// -------------------- DEFINES --------------------
+#define SNAPSHOT_TREE_MAGIC 0x53545641u // "AVTS"
+#define SNAPSHOT_HASH_MAGIC 0x53485341u // "ASHS"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_ALIGNMENT 8
+
+// --------------------- READ ME ---------------------
+// Binary snapshots of a ranked Tree and of a HashTable.
+// A snapshot holds the entries in sorted order, so loading it is one O(n) bulk build instead of n inserts,
+// and the ranks stored for a tree are the effective ranks (every pending collector already resolved).
+// Layout: header | ranks (tree only) or bucket offsets (hash only) | keys | data, every section 8 bytes aligned.
+// Functions: saveSnapshot, loadSnapshot - write / read back through mmap.
+// saveSnapshot writes "path.tmp", fsyncs it, renames it over "path" and fsyncs the directory, so a crash leaves
+// either the old or the new snapshot, whole. It stores the journal sequence the structure includes (see
+// journal.h), loadSnapshot returns it so a recovery replays only the later journal records.
+// TreeSnapshotView, HashTableSnapshotView - query a mapped snapshot in place, read only, without building.
+// Keys and data are copied byte by byte, so both have to be trivially copyable.
+
+// ---------------- SNAPSHOT EXCEPTION ----------------
+class snapshotError : public std::exception {
+public:
+    const char *what() const noexcept override {
+        return "Snapshot error";
+    }
+};
+
+// ----------------- SNAPSHOT HEADER -----------------
+struct SnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t key_size;
+    uint32_t data_size;
+    uint64_t nodes_counter;
+    uint64_t hash_size; // number of buckets, 0 for a tree snapshot
+    uint64_t journal_sequence; // the last journal operation included, 0 if none
+};
+
+static inline uint64_t snapshotAlign(uint64_t offset) {
+    return (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+// ------------------ MAPPED FILE ------------------
+// read only private mapping of a whole file, unmapped on destruction.
+// files smaller than "min_size" are rejected (a snapshot holds at least its header), an empty file maps nothing.
+class MappedFile {
+private:
+    void *address;
+    size_t length;
+
+public:
+    explicit MappedFile(const char *path, size_t min_size = sizeof(SnapshotHeader)) : address(nullptr), length(0) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            throw snapshotError();
+        struct stat file_stat{};
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t) min_size) {
+            close(fd);
+            throw snapshotError();
+        }
+        length = (size_t) file_stat.st_size;
+        if (length == 0) {
+            close(fd);
+            return;
+        }
+        address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED)
+            throw snapshotError();
+        madvise(address, length, MADV_SEQUENTIAL);
+    }
+
+    ~MappedFile() {
+        if (address != nullptr)
+            munmap(address, length);
+    }
+
+    MappedFile(const MappedFile &other) = delete;
+
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+    const char *begin() const {
+        return (const char *) address;
+    }
+
+    size_t size() const {
+        return length;
+    }
+};
+
+// makes the directory entries of the files in the directory of "path" durable (a rename or a new file)
+static inline bool syncDirectory(const char *path) {
+    std::string directory(path);
+    size_t slash = directory.rfind('/');
+    directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : directory.substr(0, slash));
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+        return false;
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+// ----------------- SNAPSHOT WRITER -----------------
+// writes "path.tmp", close() makes it durable and atomically replaces "path" with it.
+// a writer destroyed without close() (an error on the way) removes the temporary file, "path" is not touched.
+class SnapshotWriter {
+private:
+    std::string path;
+    std::string temporary_path;
+    FILE *file;
+    uint64_t offset;
+
+public:
+    explicit SnapshotWriter(const char *path) : path(path), temporary_path(std::string(path) + ".tmp"),
+                                                file(fopen(temporary_path.c_str(), "wb")), offset(0) {
+        if (file == nullptr)
+            throw snapshotError();
+    }
+
+    ~SnapshotWriter() {
+        if (file != nullptr) {
+            fclose(file);
+            unlink(temporary_path.c_str());
+        }
+    }
+
+    SnapshotWriter(const SnapshotWriter &other) = delete;
+
+    SnapshotWriter &operator=(const SnapshotWriter &other) = delete;
+
+    void write(const void *buffer, uint64_t size) {
+        if (size != 0 && fwrite(buffer, 1, size, file) != size)
+            throw snapshotError();
+        offset += size;
+    }
+
+    void writeSection(const void *buffer, uint64_t size) {
+        static const char padding[SNAPSHOT_ALIGNMENT] = {};
+        write(padding, snapshotAlign(offset) - offset);
+        write(buffer, size);
+    }
+
+    void close() {
+        if (fflush(file) != 0 || fsync(fileno(file)) != 0)
+            throw snapshotError(); // the destructor removes the temporary file
+        FILE *closed_file = file;
+        file = nullptr;
+        if (fclose(closed_file) != 0 || rename(temporary_path.c_str(), path.c_str()) != 0) {
+            unlink(temporary_path.c_str());
+            throw snapshotError();
+        }
+        if (!syncDirectory(path.c_str()))
+            throw snapshotError();
+    }
+};
+
+// validates the header and returns the offset of every section, in file order. Every section must end inside the
+// mapping, the sizes are checked one by one so a huge size cannot wrap the running offset around.
+static inline std::vector<uint64_t> snapshotSections(const MappedFile &mapped, uint32_t magic, uint32_t key_size,
+                                                     uint32_t data_size, const uint64_t *section_sizes,
+                                                     int sections_number) {
+    SnapshotHeader header{};
+    memcpy(&header, mapped.begin(), sizeof(header));
+    if (header.magic != magic || header.version != SNAPSHOT_VERSION || header.key_size != key_size ||
+        header.data_size != data_size)
+        throw snapshotError();
+    std::vector<uint64_t> offsets;
+    uint64_t offset = sizeof(SnapshotHeader);
+    for (int i = 0; i < sections_number; i++) {
+        offset = snapshotAlign(offset);
+        if (offset > mapped.size() || section_sizes[i] > mapped.size() - offset)
+            throw snapshotError();
+        offsets.push_back(offset);
+        offset += section_sizes[i];
+    }
+    return offsets;
+}
+
+static inline SnapshotHeader snapshotHeader(const MappedFile &mapped) {
+    SnapshotHeader header{};
+    memcpy(&header, mapped.begin(), sizeof(header));
+    return header;
+}
+
+// ------------------ TREE SNAPSHOT ------------------
+template<class keyType, class dataType>
+void saveSnapshot(const Tree<keyType, dataType> &tree, const char *path, uint64_t journal_sequence = 0) {
+    static_assert(std::is_trivially_copyable<keyType>::value && std::is_trivially_copyable<dataType>::value,
+                  "snapshot entries must be trivially copyable");
+    static_assert(alignof(keyType) <= SNAPSHOT_ALIGNMENT && alignof(dataType) <= SNAPSHOT_ALIGNMENT,
+                  "snapshot entries must fit the section alignment");
+    int size = tree.getNodeCounter();
+    std::vector<keyType> keys(size);
+    std::vector<dataType> data(size);
+    std::vector<double> ranks(size);
+    tree.exportInorder(keys.data(), data.data(), ranks.data());
+
+    SnapshotHeader header{SNAPSHOT_TREE_MAGIC, SNAPSHOT_VERSION, sizeof(keyType), sizeof(dataType),
+                          (uint64_t) size, 0, journal_sequence};
+    SnapshotWriter writer(path);
+    writer.write(&header, sizeof(header));
+    writer.writeSection(ranks.data(), size * sizeof(double));
+    writer.writeSection(keys.data(), size * sizeof(keyType));
+    writer.writeSection(data.data(), size * sizeof(dataType));
+    writer.close();
+}
+
+// --------------- TREE SNAPSHOT VIEW ---------------
+// read only, in place access to a tree snapshot: lookups are binary searches on the mapped keys.
+// opening rejects a node count above INT_MAX or sections that do not fit the file.
+template<class keyType, class dataType>
+class TreeSnapshotView {
+private:
+    MappedFile mapped;
+    int nodes_counter;
+    uint64_t journal_sequence;
+    const double *ranks;
+    const keyType *keys;
+    const dataType *data;
+
+    int indexOf(const keyType key) const {
+        const keyType *position = std::lower_bound(keys, keys + nodes_counter, key);
+        if (position == keys + nodes_counter || *position != key)
+            return -1;
+        return (int) (position - keys);
+    }
+
+public:
+    explicit TreeSnapshotView(const char *path) : mapped(path), nodes_counter(0), journal_sequence(0),
+                                                  ranks(nullptr), keys(nullptr), data(nullptr) {
+        SnapshotHeader header = snapshotHeader(mapped);
+        if (header.hash_size != 0 || header.nodes_counter > INT_MAX)
+            throw snapshotError(); // the section sizes below cannot overflow then
+        uint64_t size = header.nodes_counter;
+        uint64_t section_sizes[] = {size * sizeof(double), size * sizeof(keyType), size * sizeof(dataType)};
+        std::vector<uint64_t> offsets = snapshotSections(mapped, SNAPSHOT_TREE_MAGIC, sizeof(keyType),
+                                                         sizeof(dataType), section_sizes, 3);
+        nodes_counter = (int) size;
+        journal_sequence = header.journal_sequence;
+        ranks = (const double *) (mapped.begin() + offsets[0]);
+        keys = (const keyType *) (mapped.begin() + offsets[1]);
+        data = (const dataType *) (mapped.begin() + offsets[2]);
+    }
+
+    int getNodeCounter() const {
+        return nodes_counter;
+    }
+
+    uint64_t getJournalSequence() const {
+        return journal_sequence;
+    }
+
+    const keyType *getKeys() const {
+        return keys;
+    }
+
+    const dataType *getData() const {
+        return data;
+    }
+
+    const double *getRanks() const {
+        return ranks;
+    }
+
+    // returns nullptr if the key does not exist
+    const dataType *find(const keyType key) const {
+        int index = indexOf(key);
+        return index < 0 ? nullptr : data + index;
+    }
+
+    double getNodeRank(const keyType key) const {
+        int index = indexOf(key);
+        return index < 0 ? 0.0 : ranks[index];
+    }
+};
+
+// returns the journal sequence stored in the snapshot
+template<class keyType, class dataType>
+uint64_t loadSnapshot(Tree<keyType, dataType> &tree, const char *path) {
+    TreeSnapshotView<keyType, dataType> view(path);
+    tree.buildFromSorted(view.getKeys(), view.getData(), view.getRanks(), view.getNodeCounter());
+    return view.getJournalSequence();
+}
+
+// ---------------- HASH TABLE SNAPSHOT ----------------
+template<class dataType>
+void saveSnapshot(HashTable<dataType> &table, const char *path, uint64_t journal_sequence = 0) {
+    static_assert(std::is_trivially_copyable<dataType>::value, "snapshot entries must be trivially copyable");
+    static_assert(alignof(dataType) <= SNAPSHOT_ALIGNMENT, "snapshot entries must fit the section alignment");
+    table.finishRehash();
+    int hash_size = table.getHashSize();
+    int size = table.getNodesCounter();
+    std::vector<uint64_t> bucket_offsets(hash_size + 1);
+    std::vector<int> keys(size);
+    std::vector<dataType> data(size);
+    uint64_t offset = 0;
+    for (int i = 0; i < hash_size; i++) {
+        bucket_offsets[i] = offset;
+        const HashBucket<dataType> &bucket = table.getBucket(i);
+        bucket.exportInorder(keys.data() + offset, data.data() + offset);
+        offset += bucket.getNodeCounter();
+    }
+    bucket_offsets[hash_size] = offset;
+
+    SnapshotHeader header{SNAPSHOT_HASH_MAGIC, SNAPSHOT_VERSION, sizeof(int), sizeof(dataType),
+                          (uint64_t) size, (uint64_t) hash_size, journal_sequence};
+    SnapshotWriter writer(path);
+    writer.write(&header, sizeof(header));
+    writer.writeSection(bucket_offsets.data(), bucket_offsets.size() * sizeof(uint64_t));
+    writer.writeSection(keys.data(), size * sizeof(int));
+    writer.writeSection(data.data(), size * sizeof(dataType));
+    writer.close();
+}
+
+// ------------- HASH TABLE SNAPSHOT VIEW -------------
+// read only, in place access to a hash table snapshot: hash to the bucket, then binary search inside it.
+// opening validates the bucket offsets (O(hash size)), a corrupted file would index out of the key section.
+template<class dataType>
+class HashTableSnapshotView {
+private:
+    MappedFile mapped;
+    int hash_size;
+    int nodes_counter;
+    uint64_t journal_sequence;
+    const uint64_t *bucket_offsets;
+    const int *keys;
+    const dataType *data;
+
+public:
+    explicit HashTableSnapshotView(const char *path) : mapped(path), hash_size(0), nodes_counter(0),
+                                                       journal_sequence(0), bucket_offsets(nullptr), keys(nullptr),
+                                                       data(nullptr) {
+        SnapshotHeader header = snapshotHeader(mapped);
+        if (header.hash_size == 0 || header.hash_size > INT_MAX || header.nodes_counter > INT_MAX)
+            throw snapshotError();
+        uint64_t size = header.nodes_counter;
+        uint64_t section_sizes[] = {(header.hash_size + 1) * sizeof(uint64_t), size * sizeof(int),
+                                    size * sizeof(dataType)};
+        std::vector<uint64_t> offsets = snapshotSections(mapped, SNAPSHOT_HASH_MAGIC, sizeof(int),
+                                                         sizeof(dataType), section_sizes, 3);
+        hash_size = (int) header.hash_size;
+        nodes_counter = (int) size;
+        journal_sequence = header.journal_sequence;
+        bucket_offsets = (const uint64_t *) (mapped.begin() + offsets[0]);
+        keys = (const int *) (mapped.begin() + offsets[1]);
+        data = (const dataType *) (mapped.begin() + offsets[2]);
+        if (bucket_offsets[0] != 0 || bucket_offsets[hash_size] != size)
+            throw snapshotError();
+        for (int i = 0; i < hash_size; i++) {
+            if (bucket_offsets[i + 1] < bucket_offsets[i] || bucket_offsets[i + 1] > size)
+                throw snapshotError();
+        }
+    }
+
+    int getHashSize() const {
+        return hash_size;
+    }
+
+    int getNodesCounter() const {
+        return nodes_counter;
+    }
+
+    uint64_t getJournalSequence() const {
+        return journal_sequence;
+    }
+
+    const uint64_t *getBucketOffsets() const {
+        return bucket_offsets;
+    }
+
+    const int *getKeys() const {
+        return keys;
+    }
+
+    const dataType *getData() const {
+        return data;
+    }
+
+    // returns nullptr if the key does not exist
+    const dataType *find(int key) const {
+        int index = HashTable<dataType>::hashFunction(key, hash_size);
+        const int *first = keys + bucket_offsets[index];
+        const int *last = keys + bucket_offsets[index + 1];
+        const int *position = std::lower_bound(first, last, key);
+        if (position == last || *position != key)
+            return nullptr;
+        return data + (position - keys);
+    }
+
+    bool nodeExist(int key) const {
+        return find(key) != nullptr;
+    }
+};
+
+// returns the journal sequence stored in the snapshot
+template<class dataType>
+uint64_t loadSnapshot(HashTable<dataType> &table, const char *path) {
+    HashTableSnapshotView<dataType> view(path);
+    table.buildFromSorted(view.getHashSize(), view.getBucketOffsets(), view.getKeys(), view.getData());
+    return view.getJournalSequence();
+}
+
+#endif /* SNAPSHOT_H */